@@ -7,10 +7,46 @@
 /// Enables log messages and assertions.
 static constexpr bool gEnableLogging = true;
 
+/// Log messages below this level are compiled out entirely.
+/// 0 = trace, 1 = debug, 2 = info, 3 = warn, 4 = error, 5 = fatal
+static constexpr int gMinimumLogLevel = 2;
+
 /// Enables the fast memory optimization.
 /// Can somewhat increases framerates.
 static constexpr bool gEnableFastMemory = true;
 
+/// Mirror guest memory in a reserved host address range, so that most loads
+/// do not need a pagetable lookup. Only has an effect on x86-64 Linux.
+static constexpr bool gEnableFastMemoryArena = true;
+
 /// Sychronize ARM7 and ARM9 less frequently.
 /// Dramatically increases framerates.
+/// The CPUs run in slices of adaptive length, which shrink while the CPUs talk to each other.
 static constexpr bool gLooselySynchronizeCPUs = true;
+
+/// Run the ARM7 on a second host thread, in parallel to the ARM9.
+/// The CPUs still meet at every hardware event and after at most gParallelCPUSkew cycles.
+/// Uses two host cores per emulator instance.
+static constexpr bool gRunCPUsInParallel = false;
+
+/// Maximum number of (ARM7) cycles the CPUs may drift apart while running in parallel.
+/// Each slice costs a thread handoff, so this should be a lot longer than the shortest slices.
+static constexpr int gParallelCPUSkew = 256;
+
+/// Keep pending hardware events in a hierarchical timing wheel, where adding
+/// and cancelling an event takes constant time. Otherwise a binary heap is used.
+/// Both run events that are due at the same time in the order they were added.
+static constexpr bool gUseTimingWheelScheduler = true;
+
+/// Resample audio to the rate of the audio device with a windowed sinc filter.
+/// Linear interpolation is cheaper, but muffles high frequencies.
+static constexpr bool gUseSincResampler = true;
+
+/// Collect per-subsystem host time counters and report them once per second.
+/// Compiles to nothing when disabled.
+static constexpr bool gEnableProfiling = false;
+
+/// Allow recording a Chrome trace-event (chrome://tracing, Perfetto) timeline
+/// of scheduler events, IRQs, DMA transfers and GPU work.
+/// Compiles to nothing when disabled.
+static constexpr bool gEnableTracing = false;
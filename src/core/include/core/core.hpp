@@ -9,6 +9,7 @@
 #include <core/device/video_device.hpp>
 #include <util/integer.hpp>
 #include <string>
+#include <vector>
 
 namespace Duality::Core {
 
@@ -23,6 +24,37 @@ struct Core {
  void Reset();
  void Run(uint cycles);
 
+ /// Write modified firmware and cartridge save data back to disk.
+ /// Save data is also written back in the background shortly after the game modifies it,
+ /// and both happen automatically when the core is destroyed.
+ void SyncStorage();
+
+ /// Serialize the complete emulator state into the given buffer.
+ /// Persistent storage (cartridge backup and firmware) is not included.
+ /// Must not be called while Run() is executing.
+ void SaveState(std::vector<u8>& buffer);
+
+ /// Serialize the emulator state, but only include the guest RAM pages
+ /// (main RAM, WRAM and VRAM) that were written since the previous incremental state
+ /// or since the last LoadState() / Reset().
+ /// To load it, the emulator must be in the state it was in when the previous
+ /// incremental state was taken. This makes it cheap enough for rewind and rollback.
+ void SaveStateIncremental(std::vector<u8>& buffer);
+
+ /// Restore a save state created by SaveState() or SaveStateIncremental() for the same game.
+ /// Returns false and leaves the emulator untouched if the state is invalid.
+ auto LoadState(std::vector<u8> const& buffer) -> bool;
+
+ /// Like LoadState(), but without taking a copy of the current state to roll back to,
+ /// which is most of the cost of loading. Only for states this core has created itself,
+ /// e.g. a rewind history. If such a state is invalid anyway, the emulator state is undefined.
+ auto LoadStateTrusted(std::vector<u8> const& buffer) -> bool;
+
+ /// Start recording a Chrome trace-event timeline to the given JSON file.
+ /// Requires gEnableTracing. Must not be called while Run() is executing.
+ void StartTrace(std::string const& path);
+ void StopTrace();
+
 private:
   struct CoreImpl* pimpl = nullptr;
 };
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <util/log.hpp>
+
+#include "arena.hpp"
+
+#ifdef DUALITY_HAVE_FAST_MEMORY_ARENA
+
+#include <algorithm>
+#include <mutex>
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+namespace Duality::Core::arm {
+
+/// Entry of the table emitted by FastMemoryArena::Load().
+struct LoadSite {
+  uintptr_t address;
+  uintptr_t fault;
+};
+
+// Bounds of the table, provided by the linker.
+extern "C" __attribute__((weak)) LoadSite __start_duality_arena_loads[];
+extern "C" __attribute__((weak)) LoadSite __stop_duality_arena_loads[];
+
+static struct sigaction previous_action;
+
+static void OnSegmentationFault(int signal, siginfo_t* info, void* context) {
+  auto& rip = static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_RIP];
+  auto begin = __start_duality_arena_loads;
+  auto end = __stop_duality_arena_loads;
+
+  auto site = std::lower_bound(begin, end, uintptr_t(rip), [](LoadSite const& site, uintptr_t address) {
+    return site.address < address;
+  });
+
+  if (site != end && site->address == uintptr_t(rip)) {
+    rip = site->fault;
+    return;
+  }
+
+  // Not caused by the arena, let the previous handler deal with it.
+  if (previous_action.sa_flags & SA_SIGINFO) {
+    previous_action.sa_sigaction(signal, info, context);
+  } else if (previous_action.sa_handler != SIG_DFL && previous_action.sa_handler != SIG_IGN) {
+    previous_action.sa_handler(signal);
+  } else {
+    // Returning re-executes the instruction, which now faults with the default action.
+    sigaction(SIGSEGV, &previous_action, nullptr);
+  }
+}
+
+static bool InstallFaultHandler() {
+  static std::once_flag once;
+  static bool success = false;
+
+  std::call_once(once, []() {
+    std::sort(__start_duality_arena_loads, __stop_duality_arena_loads, [](LoadSite const& a, LoadSite const& b) {
+      return a.address < b.address;
+    });
+
+    struct sigaction action = {};
+    action.sa_sigaction = OnSegmentationFault;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    success = sigaction(SIGSEGV, &action, &previous_action) == 0;
+  });
+
+  return success;
+}
+
+auto FastMemoryArena::Create(common::SharedMemory& memory) -> std::unique_ptr<FastMemoryArena> {
+  if (!memory.IsShared() || !InstallFaultHandler()) {
+    return nullptr;
+  }
+
+  auto base = mmap(nullptr, kSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) {
+    LOG_WARN("FastMemoryArena: failed to reserve 4 GiB of address space.");
+    return nullptr;
+  }
+
+  return std::unique_ptr<FastMemoryArena>{new FastMemoryArena{memory, static_cast<u8*>(base)}};
+}
+
+FastMemoryArena::~FastMemoryArena() {
+  munmap(base, kSize);
+}
+
+void FastMemoryArena::Map(u32 address, u8 const* page) {
+  constexpr u64 kPageSize = common::SharedMemory::kPageSize;
+
+  u64 offset = 0;
+  bool mapped = page != nullptr && memory.GetOffset(page, offset);
+
+  UpdateRegionMap(address, mapped);
+
+  if (pending.size != 0 &&
+      pending.address + pending.size == address &&
+      pending.mapped == mapped &&
+      (!mapped || pending.offset + pending.size == offset)) {
+    pending.size += kPageSize;
+    return;
+  }
+
+  Flush();
+  pending = {address, kPageSize, offset, mapped};
+}
+
+void FastMemoryArena::UpdateRegionMap(u32 address, bool mapped) {
+  auto page = address / common::SharedMemory::kPageSize;
+  auto& word = mapped_pages[page / 64];
+  auto bit = 1ULL << (page % 64);
+
+  if (((word & bit) != 0) == mapped) {
+    return;
+  }
+
+  word ^= bit;
+
+  auto region = address >> kRegionShift;
+  auto& count = mapped_page_count[region];
+  count += mapped ? 1 : -1;
+
+  if (count != 0) {
+    region_map[region / 64] |= 1ULL << (region % 64);
+  } else {
+    region_map[region / 64] &= ~(1ULL << (region % 64));
+  }
+}
+
+bool FastMemoryArena::Flush() {
+  if (pending.size != 0 && !failed) {
+    void* result;
+
+    if (pending.mapped) {
+      result = mmap(base + pending.address, pending.size, PROT_READ,
+        MAP_SHARED | MAP_FIXED, memory.GetFile(), pending.offset);
+    } else {
+      result = mmap(base + pending.address, pending.size, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    }
+
+    failed = result == MAP_FAILED;
+  }
+
+  pending = {};
+  return !failed;
+}
+
+} // namespace Duality::Core::arm
+
+#else
+
+namespace Duality::Core::arm {
+
+auto FastMemoryArena::Create(common::SharedMemory& memory) -> std::unique_ptr<FastMemoryArena> {
+  return nullptr;
+}
+
+FastMemoryArena::~FastMemoryArena() {}
+void FastMemoryArena::Map(u32 address, u8 const* page) {}
+void FastMemoryArena::UpdateRegionMap(u32 address, bool mapped) {}
+bool FastMemoryArena::Flush() { return false; }
+
+} // namespace Duality::Core::arm
+
+#endif
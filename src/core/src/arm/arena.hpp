@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <memory>
+#include <util/integer.hpp>
+#include <vector>
+#include <util/shared_memory.hpp>
+
+#if defined(__linux__) && defined(__x86_64__) && \
+    ((defined(__clang__) && __clang_major__ >= 11) || (!defined(__clang__) && __GNUC__ >= 11))
+  #define DUALITY_HAVE_FAST_MEMORY_ARENA
+#endif
+
+namespace Duality::Core::arm {
+
+/// Reserves 4 GiB of host address space that mirrors the readable guest pages,
+/// so that a guest load is a single host load from base + address.
+/// Pages are mapped from a shared memory pool, which makes mirrors real aliases of the same memory.
+/// Pages that are not mapped (unmapped guest memory, memory outside of the pool) fault on access;
+/// the fault handler resumes execution at the slow path of the load (see Load()).
+/// Only available on x86-64 Linux, elsewhere Create() returns nullptr.
+struct FastMemoryArena {
+ ~FastMemoryArena();
+
+  static auto Create(common::SharedMemory& memory) -> std::unique_ptr<FastMemoryArena>;
+
+  auto GetBase() -> u8* { return base; }
+
+  /// One bit for each 16 MiB region of the guest address space, set if any page in it is mapped.
+  /// Loads from other regions always fault, so they should not go through the arena.
+  auto GetRegionMap() const -> u64 const* { return region_map; }
+
+  /// Mirror the guest page at `address` to the host page `page`. If `page` is not part of the
+  /// shared memory pool (or nullptr), accesses to the guest page fault.
+  /// Consecutive pages are batched, call Flush() to apply the changes.
+  void Map(u32 address, u8 const* page);
+
+  /// Returns false if the host ran out of mappings, the arena must not be used afterwards.
+  bool Flush();
+
+  /// Load a value from the arena. Returns false if the access faulted.
+  template<typename T>
+  static bool Load(u8 const* base, u32 address, T& value);
+
+private:
+  FastMemoryArena(common::SharedMemory& memory, u8* base)
+      : memory(memory)
+      , base(base)
+      , mapped_pages(kPageCount / 64) {}
+
+  static constexpr u64 kSize = 0x100000000ULL;
+  static constexpr int kRegionShift = 24;
+  static constexpr int kRegionCount = int(kSize >> kRegionShift);
+  static constexpr int kPageCount = int(kSize / common::SharedMemory::kPageSize);
+
+  void UpdateRegionMap(u32 address, bool mapped);
+
+  /// A range of guest pages that maps to a contiguous range in the shared memory pool,
+  /// or to nothing (`mapped` is false).
+  struct Run {
+    u64 address = 0;
+    u64 size = 0;
+    u64 offset = 0;
+    bool mapped = false;
+  } pending;
+
+  common::SharedMemory& memory;
+  u8* base;
+  bool failed = false;
+
+  /// One bit for each guest page that is mapped, and the number of mapped pages in each region.
+  std::vector<u64> mapped_pages;
+  u16 mapped_page_count[kRegionCount] {};
+  u64 region_map[kRegionCount / 64] {};
+};
+
+#ifdef DUALITY_HAVE_FAST_MEMORY_ARENA
+
+// Every load records its address and the address of its slow path in a table,
+// which the fault handler uses to resume execution after a fault.
+// The table entry joins the section group of the function ("?"), so that it is
+// discarded together with duplicate instances of inline functions.
+#define DUALITY_ARENA_LOAD(instruction) \
+  asm goto( \
+    "1: " instruction " (%[base], %[address]), %[value]\n" \
+    ".pushsection duality_arena_loads, \"aw?\"\n" \
+    ".balign 8\n" \
+    ".quad 1b, %l[fault]\n" \
+    ".popsection\n" \
+    : [value] "=r" (value) \
+    : [base] "r" (base), [address] "r" (u64(address)) \
+    : "memory" \
+    : fault \
+  )
+
+template<typename T>
+inline bool FastMemoryArena::Load(u8 const* base, u32 address, T& value) {
+  if constexpr (sizeof(T) == 1) DUALITY_ARENA_LOAD("movb");
+  if constexpr (sizeof(T) == 2) DUALITY_ARENA_LOAD("movw");
+  if constexpr (sizeof(T) == 4) DUALITY_ARENA_LOAD("movl");
+  if constexpr (sizeof(T) == 8) DUALITY_ARENA_LOAD("movq");
+  return true;
+fault:
+  return false;
+}
+
+#undef DUALITY_ARENA_LOAD
+
+#else
+
+template<typename T>
+inline bool FastMemoryArena::Load(u8 const* base, u32 address, T& value) {
+  return false;
+}
+
+#endif
+
+} // namespace Duality::Core::arm
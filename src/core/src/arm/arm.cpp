@@ -12,6 +12,7 @@ void ARM::Reset() {
   constexpr u32 nop = 0xE320F000;
 
   state.Reset();
+  InvalidateCodePage();
   SwitchMode(MODE_SYS);
   opcode[0] = nop;
   opcode[1] = nop;
@@ -24,13 +25,47 @@ void ARM::Reset() {
       coprocessor->Reset();
 }
 
-void ARM::Run(int instructions) {
+void ARM::LoadState(StateReader& state) {
+  state.Read(this->state);
+  state.Read(opcode);
+  state.Read(exception_base);
+  state.Read(wait_for_irq);
+  irq_line = state.Read<bool>();
+
+  switch (this->state.cpsr.f.mode) {
+    case MODE_USR:
+    case MODE_SYS:
+    case MODE_FIQ:
+    case MODE_IRQ:
+    case MODE_SVC:
+    case MODE_ABT:
+    case MODE_UND:
+      break;
+    default:
+      state.Check(false, "ARM: bad CPU mode in save state.");
+  }
+
+  p_spsr = &this->state.spsr[GetRegisterBankByMode(this->state.cpsr.f.mode)];
+  InvalidateCodePage();
+}
+
+void ARM::SaveState(StateWriter& state) {
+  state.Write(this->state);
+  state.Write(opcode);
+  state.Write(exception_base);
+  state.Write(wait_for_irq);
+  state.Write<bool>(irq_line);
+}
+
+auto ARM::Run(int instructions) -> int {
   if (IsWaitingForIRQ() && !IRQLine()) {
-    return;
+    return instructions;
   }
 
-  while (instructions-- > 0) {
-    if (IRQLine()) SignalIRQ();
+  stop_requested.store(false, std::memory_order_relaxed);
+
+  for (int i = 0; i < instructions; i++) {
+    if (irq_line.load(std::memory_order_relaxed)) SignalIRQ();
 
     auto instruction = opcode[0];
     if (state.cpsr.f.thumb) {
@@ -53,12 +88,16 @@ void ARM::Run(int instructions) {
         }
         (this->*s_opcode_lut_32[hash])(instruction);
 
-        if (IsWaitingForIRQ()) return;
+        if (IsWaitingForIRQ()) return instructions;
       } else {
         state.r15 += 4;
       }
     }
+
+    if (unlikely(stop_requested.load(std::memory_order_relaxed))) return i + 1;
   }
+
+  return instructions;
 }
 
 
@@ -97,6 +136,17 @@ void ARM::SignalIRQ() {
   ReloadPipeline32();
 }
 
+void ARM::UpdateCodePage(u32 address) {
+  auto number = address >> MemoryBase::kPageShift;
+  auto table = memory->code_pagetable;
+
+  code_page = {};
+
+  if (gEnableFastMemory && table != nullptr && (*table)[number] != nullptr) {
+    code_page = {number, (*table)[number]};
+  }
+}
+
 void ARM::ReloadPipeline32() {
   opcode[0] = ReadWordCode(state.r15);
   opcode[1] = ReadWordCode(state.r15 + 4);
@@ -5,11 +5,13 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <util/log.hpp>
 
 #include "coprocessor.hpp"
 #include "state.hpp"
 #include "memory.hpp"
+#include "save_state.hpp"
 
 namespace Duality::Core::arm {
 
@@ -24,6 +26,9 @@ struct ARM {
       : arch(arch)
       , memory(memory) {
     BuildConditionTable();
+    memory->AddMemoryMapCallback([this]() {
+      InvalidateCodePage();
+    });
     Reset();
   }
 
@@ -31,12 +36,20 @@ struct ARM {
   void ExceptionBase(u32 base) { exception_base = base; } 
 
   void Reset();
-  void Run(int instructions);
+  /// Returns the number of cycles that passed, which is only less than requested if Stop() was called.
+  /// Waiting for an IRQ consumes the remaining cycles.
+  auto Run(int instructions) -> int;
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   void AttachCoprocessor(uint id, Coprocessor* coprocessor);
-  auto IRQLine() -> bool& { return irq_line; }
+  auto IRQLine() -> std::atomic<bool>& { return irq_line; }
   void WaitForIRQ() { wait_for_irq = true; }
   bool IsWaitingForIRQ() { return wait_for_irq; }
 
+  /// Make Run() return after the current instruction, e.g. because DMA took over the bus.
+  /// May be called from another thread while Run() is executing.
+  void Stop() { stop_requested.store(true, std::memory_order_relaxed); }
+
   // TODO: implement a cleaner interface to modify the execution state.
   auto GetState() -> State& { return state; }
   void SetPC(u32 value) {
@@ -61,6 +74,11 @@ private:
   void ReloadPipeline32();
   void BuildConditionTable();
   bool CheckCondition(Condition condition);
+  void UpdateCodePage(u32 address);
+
+  void InvalidateCodePage() {
+    code_page = {};
+  }
 
   #include "handlers/arithmetic.inl"
   #include "handlers/handler16.inl"
@@ -70,15 +88,25 @@ private:
   Architecture arch;
   u32 exception_base = 0;
   bool wait_for_irq = false;
+  std::atomic<bool> stop_requested = false;
   MemoryBase* memory;
   Coprocessor* coprocessors[16] { nullptr };
 
   State state;
   State::StatusRegister* p_spsr;
-  bool irq_line;
+  /// Atomic, because the IRQ controller may be written by the other CPU (see gRunCPUsInParallel).
+  std::atomic<bool> irq_line;
 
   u32 opcode[2];
 
+  /// Host memory of the page that instructions were last fetched from.
+  /// Sequential fetches within that page skip the memory system entirely.
+  struct CodePage {
+    /// Guest page number (address >> MemoryBase::kPageShift), never matches if invalid.
+    u32 number = ~0U;
+    u8* data = nullptr;
+  } code_page;
+
   bool condition_table[16][16];
   
   static std::array<Handler16, 2048> s_opcode_lut_16;
@@ -16,12 +16,24 @@ auto ReadWord(u32 address) -> u32 {
   return memory->FastRead<u32, Bus::Data>(address);
 }
 
+template<typename T>
+auto ReadCode(u32 address) -> T {
+  if (unlikely((address >> MemoryBase::kPageShift) != code_page.number)) {
+    UpdateCodePage(address);
+    if (code_page.data == nullptr) {
+      return memory->FastRead<T, Bus::Code>(address);
+    }
+  }
+
+  return read<T>(code_page.data, address & MemoryBase::kPageMask & ~(sizeof(T) - 1));
+}
+
 auto ReadHalfCode(u32 address) -> u32 {
-  return memory->FastRead<u16, Bus::Code>(address);
+  return ReadCode<u16>(address);
 }
 
 auto ReadWordCode(u32 address) -> u32 {
-  return memory->FastRead<u32, Bus::Code>(address);
+  return ReadCode<u32>(address);
 }
 
 auto ReadByteSigned(u32 address) -> u32 {
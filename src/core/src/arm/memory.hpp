@@ -6,11 +6,15 @@
 
 #include <array>
 #include <buildconfig.hpp>
+#include <functional>
 #include <util/integer.hpp>
 #include <util/likely.hpp>
 #include <util/meta.hpp>
 #include <util/punning.hpp>
 #include <memory>
+#include <vector>
+
+#include "arena.hpp"
 
 namespace Duality::Core::arm {
 
@@ -42,24 +46,24 @@ struct MemoryBase {
 
     address &= ~(sizeof(T) - 1);
 
-    if constexpr (gEnableFastMemory && bus != Bus::System) {
-      if (itcm.config.enable_read &&
-          address >= itcm.config.base &&
-          address <= itcm.config.limit) {
-        return read<T>(itcm.data, (address - itcm.config.base) & itcm.mask);
-      }
-    }
-
-    if constexpr (gEnableFastMemory && bus == Bus::Data) {
-      if (dtcm.config.enable_read && address >= dtcm.config.base && address <= dtcm.config.limit) {
-        return read<T>(dtcm.data, (address - dtcm.config.base) & dtcm.mask);
+    if constexpr (gEnableFastMemory && gEnableFastMemoryArena && bus == Bus::Data) {
+      // Do not take a host fault for every access to a region without mapped pages, e.g. I/O registers.
+      auto region = address >> 24;
+      if (likely(arena_base != nullptr) && ((arena_region_map[region / 64] >> (region % 64)) & 1) != 0) {
+        T value;
+        if (likely(FastMemoryArena::Load<T>(arena_base, address, value))) {
+          return value;
+        }
       }
     }
 
-    if (gEnableFastMemory && likely(pagetable != nullptr)) {
-      auto page = (*pagetable)[address >> kPageShift];
-      if (likely(page != nullptr)) {
-        return read<T>(page, address & kPageMask);
+    if constexpr (gEnableFastMemory) {
+      auto table = GetReadPageTable<bus>();
+      if (likely(table != nullptr)) {
+        auto page = (*table)[address >> kPageShift];
+        if (likely(page != nullptr)) {
+          return read<T>(page, address & kPageMask);
+        }
       }
     }
 
@@ -75,27 +79,16 @@ struct MemoryBase {
 
     address &= ~(sizeof(T) - 1);
 
-    if constexpr (gEnableFastMemory && bus != Bus::System) {
-      if (itcm.config.enable &&
-          address >= itcm.config.base &&
-          address <= itcm.config.limit) {
-        write<T>(itcm.data, (address - itcm.config.base) & itcm.mask, value);
-        return;
-      }
-
-      if (dtcm.config.enable &&
-          address >= dtcm.config.base &&
-          address <= dtcm.config.limit) {
-        write<T>(dtcm.data, (address - dtcm.config.base) & dtcm.mask, value);
-        return;
-      }
-    }
-
-    if (gEnableFastMemory && likely(pagetable != nullptr)) {
-      auto page = (*pagetable)[address >> kPageShift];
-      if (likely(page != nullptr)) {
-        write<T>(page, address & kPageMask, value);
-        return;
+    if constexpr (gEnableFastMemory) {
+      auto table = bus == Bus::System ? write_pagetable.get() : cpu_write_pagetable;
+      if (likely(table != nullptr)) {
+        auto index = address >> kPageShift;
+        auto page = (*table)[index];
+        if (likely(page != nullptr)) {
+          write<T>(page, address & kPageMask, value);
+          *(*dirtytable)[index] = 1;
+          return;
+        }
       }
     }
 
@@ -108,7 +101,54 @@ struct MemoryBase {
   static constexpr int kPageShift = 12; // 2^12 = 4096
   static constexpr int kPageMask = (1 << kPageShift) - 1;
 
-  std::unique_ptr<std::array<u8*, 1048576>> pagetable = nullptr;
+  using PageTable = std::array<u8*, 1048576>;
+
+  template<Bus bus>
+  auto GetReadPageTable() -> PageTable* {
+    if constexpr (bus == Bus::Code) return code_pagetable;
+    if constexpr (bus == Bus::Data) return data_pagetable;
+    if constexpr (bus == Bus::System) return pagetable.get();
+  }
+
+  using Callback = std::function<void(void)>;
+
+  /// Register a function to be called whenever the pagetables or the TCM configuration change,
+  /// so that host pointers obtained from them can be invalidated.
+  void AddMemoryMapCallback(Callback callback) {
+    memory_map_callbacks.push_back(callback);
+  }
+
+  void OnMemoryMapChanged() {
+    for (auto const& callback : memory_map_callbacks) callback();
+  }
+
+  /// Host memory of each page that can be read directly.
+  /// These pagetables describe the system bus (DMA), which does not see the TCMs.
+  std::unique_ptr<PageTable> pagetable = nullptr;
+
+  /// Host memory of each page that can be written directly.
+  /// Pages that are read-only (BIOS) or need special handling on writes
+  /// (e.g. mirrors that must be kept in sync) are only in the read pagetable.
+  std::unique_ptr<PageTable> write_pagetable = nullptr;
+
+  /// Dirty flag of each page in the write pagetable (see DirtyPageTracker).
+  /// Must be allocated together with the pagetables and never contains nullptr.
+  /// CPU writes to TCM pages may mark the page underneath as dirty, which is harmless.
+  std::unique_ptr<PageTable> dirtytable = nullptr;
+
+  /// Pagetables for CPU instruction fetches and data accesses,
+  /// which have the TCM pages (see TCM::Config) folded in, so that every
+  /// fast access is a single lookup. They must be rebuilt when the TCM configuration changes.
+  /// Memory systems without TCMs point them to the system bus pagetables.
+  PageTable* code_pagetable = nullptr;
+  PageTable* data_pagetable = nullptr;
+  PageTable* cpu_write_pagetable = nullptr;
+
+  /// Host address range that mirrors the data pagetable, if the host supports it.
+  /// Must be kept in sync with the data pagetable.
+  std::unique_ptr<FastMemoryArena> arena = nullptr;
+  u8* arena_base = nullptr;
+  u64 const* arena_region_map = nullptr;
 
   struct TCM {
     u8* data = nullptr;
@@ -119,8 +159,19 @@ struct MemoryBase {
       bool enable_read = false;
       u32 base = 0;
       u32 limit = 0;
+
+      bool operator==(Config const& other) const {
+        return enable == other.enable && enable_read == other.enable_read &&
+               base == other.base && limit == other.limit;
+      }
+
+      bool operator!=(Config const& other) const {
+        return !(*this == other);
+      }
     } config;
   } itcm, dtcm;
+
+  std::vector<Callback> memory_map_callbacks;
 };
 
 } // namespace Duality::Core::arm
@@ -3,6 +3,7 @@
  */
 
 #include "arm7.hpp"
+#include "profiler.hpp"
 
 namespace Duality::Core {
 
@@ -13,6 +14,7 @@ ARM7::ARM7(Interconnect& interconnect)
   core.AttachCoprocessor(14, &cp14);
   irq.SetCore(core);
   interconnect.dma7.SetMemory(&bus);
+  interconnect.dma7.SetCore(core);
   interconnect.apu.SetMemory(&bus);
   Reset(0);
 }
@@ -27,11 +29,24 @@ void ARM7::Reset(u32 entrypoint) {
   core.SetPC(entrypoint);
 }
 
-void ARM7::Run(uint cycles) {
+void ARM7::LoadState(StateReader& state) {
+  bus.LoadState(state);
+  core.LoadState(state);
+}
+
+void ARM7::SaveState(StateWriter& state) {
+  bus.SaveState(state);
+  core.SaveState(state);
+}
+
+auto ARM7::Run(uint cycles) -> uint {
+  Profiler::Scope scope{Profiler::Section::ARM7};
+
   if (!bus.IsHalted() || irq.HasPendingIRQ()) {
     bus.IsHalted() = false;
-    core.Run(cycles);
+    return core.Run(cycles);
   }
+  return cycles;
 }
 
 } // namespace Duality::Core
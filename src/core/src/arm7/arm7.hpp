@@ -14,9 +14,12 @@ struct ARM7 {
   ARM7(Interconnect& interconnect);
 
   void Reset(u32 entrypoint);
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   auto Bus() -> ARM7MemoryBus& { return bus; }
   bool IsHalted() { return bus.IsHalted(); }
-  void Run(uint cycles);
+  /// Returns the number of cycles that passed, see arm::ARM::Run().
+  auto Run(uint cycles) -> uint;
 
 private:
   /// No-operation stub for the CP14 coprocessor
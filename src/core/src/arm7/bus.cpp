@@ -13,7 +13,9 @@
 namespace Duality::Core {
 
 ARM7MemoryBus::ARM7MemoryBus(Interconnect* interconnect) 
-    : ewram(interconnect->ewram)
+    : bios(interconnect->memory.Allocate(0x4000))
+    , iwram(interconnect->memory.Allocate(0x10000))
+    , ewram(interconnect->ewram)
     , swram(interconnect->swram.arm7)
     , apu(interconnect->apu)
     , cart(interconnect->cart)
@@ -25,18 +27,37 @@ ARM7MemoryBus::ARM7MemoryBus(Interconnect* interconnect)
     , video_unit(interconnect->video_unit)
     , vram(interconnect->video_unit.vram)
     , wramcnt(interconnect->wramcnt)
+    , cpu_sync(interconnect->cpu_sync)
     , keyinput(interconnect->keyinput)
-    , extkeyinput(interconnect->extkeyinput) {
+    , extkeyinput(interconnect->extkeyinput)
+    , dirty_pages(interconnect->dirty_pages) {
   std::ifstream file { "bios7.bin", std::ios::in | std::ios::binary };
   ASSERT(file.good(), "ARM7: failed to open bios7.bin");
   file.read(reinterpret_cast<char*>(bios), 16384);
   ASSERT(file.good(), "ARM7: failed to read 16384 bytes from bios7.bin");
 
-  memset(iwram, 0, sizeof(iwram));
+  memset(iwram, 0, 0x10000);
   halted = false;
 
+  dirty_pages.AddRegion(iwram, 0x10000);
+
+  SetupMMIO();
+
   if constexpr (gEnableFastMemory) {
-    pagetable = std::make_unique<std::array<u8*, 1048576>>();
+    pagetable = std::make_unique<PageTable>();
+    write_pagetable = std::make_unique<PageTable>();
+    dirtytable = std::make_unique<PageTable>();
+    // The ARM7 has no TCMs, its CPU accesses see the same memory as DMA.
+    code_pagetable = pagetable.get();
+    data_pagetable = pagetable.get();
+    cpu_write_pagetable = write_pagetable.get();
+    if constexpr (gEnableFastMemoryArena) {
+      arena = arm::FastMemoryArena::Create(interconnect->memory);
+      if (arena != nullptr) {
+        arena_base = arena->GetBase();
+        arena_region_map = arena->GetRegionMap();
+      }
+    }
     UpdateMemoryMap(0, 0x100000000ULL);
     interconnect->wramcnt.AddCallback([this]() {
       UpdateMemoryMap(0x03000000, 0x04000000);
@@ -48,38 +69,66 @@ ARM7MemoryBus::ARM7MemoryBus(Interconnect* interconnect)
 }
 
 void ARM7MemoryBus::UpdateMemoryMap(u32 address_lo, u64 address_hi) {
-  auto& table = *pagetable;
+  auto& read_table = *pagetable;
+  auto& write_table = *write_pagetable;
 
   for (u64 address = address_lo; address < address_hi; address += kPageMask + 1) {
     auto index = address >> kPageShift;
+    u8* page = nullptr;
+    bool writable = true;
 
     switch (address >> 24) {
       case 0x00: {
-        table[index] = &bios[address & 0x3FFF];
+        page = &bios[address & 0x3FFF];
+        writable = false;
         break;
       }
       case 0x02: {
-        table[index] = &ewram[address & 0x3FFFFF];
+        page = &ewram[address & 0x3FFFFF];
         break;
       }
       case 0x03: {
         if ((address & 0x00800000) || swram.data == nullptr) {
-          table[index] = &iwram[address & 0xFFFF];
+          page = &iwram[address & 0xFFFF];
         } else {
-          table[index] = &swram.data[address & swram.mask];
+          page = &swram.data[address & swram.mask];
         }
         break;
       }
       case 0x06: {
-        table[index] = vram.region_arm7_wram.GetUnsafePointer<u8>(address);
-        break;
-      }
-      default: {
-        table[index] = nullptr;
+        page = vram.region_arm7_wram.GetUnsafePointer<u8>(address);
         break;
       }
     }
+
+    // The arena mirrors the read table, only remap the pages that actually changed.
+    // Remapping is expensive, and e.g. loading a save state remaps all of VRAM.
+    if (arena != nullptr && read_table[index] != page) {
+      arena->Map(address, page);
+    }
+
+    read_table[index] = page;
+    write_table[index] = writable ? page : nullptr;
+    (*dirtytable)[index] = dirty_pages.GetFlag(write_table[index]);
+  }
+
+  if (arena != nullptr && !arena->Flush()) {
+    LOG_WARN("ARM7: failed to update the fast memory arena, falling back to the pagetable.");
+    arena = nullptr;
+    arena_base = nullptr;
+    arena_region_map = nullptr;
   }
+
+  OnMemoryMapChanged();
+}
+
+/// NOTE: IWRAM is saved by the DirtyPageTracker.
+void ARM7MemoryBus::LoadState(StateReader& state) {
+  state.Read(halted);
+}
+
+void ARM7MemoryBus::SaveState(StateWriter& state) {
+  state.Write(halted);
 }
 
 template<typename T>
@@ -101,20 +150,14 @@ auto ARM7MemoryBus::Read(u32 address) -> T {
       return read<T>(swram.data, address & swram.mask);
     }
     case 0x04: {
+      auto guard = cpu_sync.LockIO();
+      cpu_sync.OnIOAccess(address);
       if constexpr (std::is_same<T, u64>::value) {
-        return ReadWordIO(address | 0) |
-          (u64(ReadWordIO(address | 4)) << 32);
-      }
-      if constexpr (std::is_same<T, u32>::value) {
-        return ReadWordIO(address);
+        return mmio.Read<u32>(address | 0) |
+          (u64(mmio.Read<u32>(address | 4)) << 32);
+      } else {
+        return mmio.Read<T>(address);
       }
-      if constexpr (std::is_same<T, u16>::value) {
-        return ReadHalfIO(address);
-      }
-      if constexpr (std::is_same<T, u8>::value) {
-        return ReadByteIO(address);
-      }
-      return 0;
     }
     case 0x06: {
       return vram.region_arm7_wram.Read<T>(address);
@@ -134,29 +177,27 @@ void ARM7MemoryBus::Write(u32 address, T value) {
   switch (address >> 24) {
     case 0x02: {
       write<T>(ewram, address & 0x3FFFFF, value);
+      dirty_pages.Mark(&ewram[address & 0x3FFFFF]);
       break;
     }
     case 0x03: {
       if ((address & 0x00800000) || swram.data == nullptr) {
         write<T>(iwram, address & 0xFFFF, value);
+        dirty_pages.Mark(&iwram[address & 0xFFFF]);
         break;
       }
       write<T>(swram.data, address & swram.mask, value);
+      dirty_pages.Mark(&swram.data[address & swram.mask]);
       break;
     }
     case 0x04: {
+      auto guard = cpu_sync.LockIO();
+      cpu_sync.OnIOAccess(address);
       if constexpr (std::is_same<T, u64>::value) {
-        WriteWordIO(address | 0, value);
-        WriteWordIO(address | 4, value >> 32);
-      }
-      if constexpr (std::is_same<T, u32>::value) {
-        WriteWordIO(address, value);
-      }
-      if constexpr (std::is_same<T, u16>::value) {
-        WriteHalfIO(address, value);
-      }
-      if constexpr (std::is_same<T, u8>::value) {
-        WriteByteIO(address, value);
+        mmio.Write<u32>(address | 0, value);
+        mmio.Write<u32>(address | 4, value >> 32);
+      } else {
+        mmio.Write<T>(address, value);
       }
       break;
     }
@@ -8,6 +8,7 @@
 
 #include "arm/memory.hpp"
 #include "interconnect.hpp"
+#include "mmio.hpp"
 
 namespace Duality::Core {
 
@@ -26,6 +27,9 @@ struct ARM7MemoryBus final : arm::MemoryBase {
   void WriteWord(u32 address, u32 value, Bus bus) override;
   void WriteQuad(u32 address, u64 value, Bus bus) override;
 
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
+
 private:
   void UpdateMemoryMap(u32 address_lo, u64 address_hi);
 
@@ -35,17 +39,12 @@ private:
   template<typename T>
   void Write(u32 address, T value);
 
-  auto ReadByteIO(u32 address) ->  u8;
-  auto ReadHalfIO(u32 address) -> u16;
-  auto ReadWordIO(u32 address) -> u32;
-  
-  void WriteByteIO(u32 address,  u8 value);
-  void WriteHalfIO(u32 address, u16 value);
-  void WriteWordIO(u32 address, u32 value);
+  void SetupMMIO();
+  void SetupAPUMMIO();
 
   /// ARM7 internal memory
-  u8 bios[0x4000] {0};
-  u8 iwram[0x10000];
+  u8* bios;
+  u8* iwram;
 
   /// ARM7 and ARM9 shared memory
   u8* ewram;
@@ -62,9 +61,14 @@ private:
   VideoUnit& video_unit;
   VRAM& vram;
   Interconnect::WRAMCNT& wramcnt;
+  CPUSync& cpu_sync;
   Interconnect::KeyInput& keyinput;
   Interconnect::ExtKeyInput& extkeyinput;
+  DirtyPageTracker& dirty_pages;
   bool halted;
+
+  /// I/O register handlers
+  MMIO mmio {"ARM7"};
 };
 
 } // namespace Duality::Core
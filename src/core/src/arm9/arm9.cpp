@@ -3,6 +3,7 @@
  */
 
 #include "arm9.hpp"
+#include "profiler.hpp"
 
 namespace Duality::Core {
 
@@ -14,6 +15,8 @@ ARM9::ARM9(Interconnect& interconnect)
   core.AttachCoprocessor(15, &cp15);
   irq.SetCore(core);
   interconnect.dma9.SetMemory(&bus);
+  interconnect.dma9.SetCore(core);
+  interconnect.cpu_sync.SetCore(core);
   Reset(0);
 }
 
@@ -26,8 +29,22 @@ void ARM9::Reset(u32 entrypoint) {
   core.SetPC(entrypoint);
 }
 
-void ARM9::Run(uint cycles) {
-  core.Run(cycles);
+void ARM9::LoadState(StateReader& state) {
+  bus.LoadState(state);
+  cp15.LoadState(state);
+  core.LoadState(state);
+}
+
+void ARM9::SaveState(StateWriter& state) {
+  bus.SaveState(state);
+  cp15.SaveState(state);
+  core.SaveState(state);
+}
+
+auto ARM9::Run(uint cycles) -> uint {
+  Profiler::Scope scope{Profiler::Section::ARM9};
+
+  return core.Run(cycles);
 }
 
 } // namespace Duality::Core
@@ -15,9 +15,12 @@ struct ARM9 {
   ARM9(Interconnect& interconnect);
 
   void Reset(u32 entrypoint);
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   auto Bus() -> ARM9MemoryBus& { return bus; }
   bool IsHalted() { return core.IsWaitingForIRQ(); }
-  void Run(uint cycles);
+  /// Returns the number of cycles that passed, see arm::ARM::Run().
+  auto Run(uint cycles) -> uint;
 
 private:
   ARM9MemoryBus bus;
@@ -13,7 +13,10 @@
 namespace Duality::Core {
 
 ARM9MemoryBus::ARM9MemoryBus(Interconnect* interconnect)
-    : ewram(interconnect->ewram)
+    : bios(interconnect->memory.Allocate(0x8000))
+    , dtcm_data(interconnect->memory.Allocate(0x4000))
+    , itcm_data(interconnect->memory.Allocate(0x8000))
+    , ewram(interconnect->ewram)
     , swram(interconnect->swram.arm9)
     , cart(interconnect->cart)
     , ipc(interconnect->ipc)
@@ -24,7 +27,9 @@ ARM9MemoryBus::ARM9MemoryBus(Interconnect* interconnect)
     , video_unit(interconnect->video_unit)
     , vram(interconnect->video_unit.vram)
     , wramcnt(interconnect->wramcnt)
-    , keyinput(interconnect->keyinput) {
+    , cpu_sync(interconnect->cpu_sync)
+    , keyinput(interconnect->keyinput)
+    , dirty_pages(interconnect->dirty_pages) {
   std::ifstream file { "bios9.bin", std::ios::in | std::ios::binary };
   ASSERT(file.good(), "ARM9: failed to open bios9.bin");
   file.read(reinterpret_cast<char*>(bios), 4096);
@@ -35,8 +40,25 @@ ARM9MemoryBus::ARM9MemoryBus(Interconnect* interconnect)
   itcm.mask = 0x7FFF;
   dtcm.mask = 0x3FFF;
 
+  SetupMMIO();
+
   if constexpr (gEnableFastMemory) {
-    pagetable = std::make_unique<std::array<u8*, 1048576>>();
+    pagetable = std::make_unique<PageTable>();
+    write_pagetable = std::make_unique<PageTable>();
+    dirtytable = std::make_unique<PageTable>();
+    code_pagetable_tcm = std::make_unique<PageTable>();
+    data_pagetable_tcm = std::make_unique<PageTable>();
+    cpu_write_pagetable_tcm = std::make_unique<PageTable>();
+    code_pagetable = code_pagetable_tcm.get();
+    data_pagetable = data_pagetable_tcm.get();
+    cpu_write_pagetable = cpu_write_pagetable_tcm.get();
+    if constexpr (gEnableFastMemoryArena) {
+      arena = arm::FastMemoryArena::Create(interconnect->memory);
+      if (arena != nullptr) {
+        arena_base = arena->GetBase();
+        arena_region_map = arena->GetRegionMap();
+      }
+    }
     UpdateMemoryMap(0, 0x100000000ULL);
     interconnect->wramcnt.AddCallback([this]() {
       UpdateMemoryMap(0x03000000, 0x04000000);
@@ -60,42 +82,130 @@ ARM9MemoryBus::ARM9MemoryBus(Interconnect* interconnect)
 }
 
 void ARM9MemoryBus::UpdateMemoryMap(u32 address_lo, u64 address_hi) {
-  auto& table = *pagetable;
+  auto& read_table = *pagetable;
+  auto& write_table = *write_pagetable;
 
   for (u64 address = address_lo; address < address_hi; address += kPageMask + 1) {
     auto index = address >> kPageShift;
+    u8* page = nullptr;
+    bool writable = true;
 
     switch (address >> 24) {
       case 0x02: {
-        table[index] = &ewram[address & 0x3FFFFF];
+        page = &ewram[address & 0x3FFFFF];
         break;
       }
       case 0x03: {
         if (swram.data != nullptr) {
-          table[index] = &swram.data[address & swram.mask];
-        } else {
-          table[index] = nullptr;
+          page = &swram.data[address & swram.mask];
         }
         break;
       }
+      case 0x05: {
+        // Writes must update both copies of the data, see VideoUnit::WritePRAM().
+        page = &video_unit.pram[0];
+        writable = false;
+        break;
+      }
       case 0x06: {
-        table[index] = VisitVRAMByAddress<GetUnsafePointerFunctor<u8>>(address);
+        page = VisitVRAMByAddress<GetUnsafePointerFunctor<u8>>(address);
+        break;
+      }
+      case 0x07: {
+        page = &video_unit.oam[0];
+        writable = false;
         break;
       }
       case 0xFF: {
         // TODO: clean up address decoding and figure out out-of-bounds reads.
         if ((address & 0xFFFF0000) == 0xFFFF0000)
-          table[index] = &bios[address & 0x7FFF];
-        break;
-      }
-      default: {
-        table[index] = nullptr;
+          page = &bios[address & 0x7FFF];
+        writable = false;
         break;
       }
     }
+
+    read_table[index] = page;
+    write_table[index] = writable ? page : nullptr;
+    (*dirtytable)[index] = dirty_pages.GetFlag(write_table[index]);
+
+    // Fold in the TCMs, the ITCM has priority over the DTCM.
+    u8* code_page = page;
+    u8* data_page = page;
+    u8* cpu_write_page = write_table[index];
+
+    if (dtcm.config.enable_read && address >= dtcm.config.base && address <= dtcm.config.limit) {
+      data_page = &dtcm_data[(address - dtcm.config.base) & 0x3FFF];
+    }
+
+    if (dtcm.config.enable && address >= dtcm.config.base && address <= dtcm.config.limit) {
+      cpu_write_page = &dtcm_data[(address - dtcm.config.base) & 0x3FFF];
+    }
+
+    if (itcm.config.enable_read && address >= itcm.config.base && address <= itcm.config.limit) {
+      code_page = data_page = &itcm_data[(address - itcm.config.base) & 0x7FFF];
+    }
+
+    if (itcm.config.enable && address >= itcm.config.base && address <= itcm.config.limit) {
+      cpu_write_page = &itcm_data[(address - itcm.config.base) & 0x7FFF];
+    }
+
+    // The arena mirrors the data table, only remap the pages that actually changed.
+    if (arena != nullptr && (*data_pagetable)[index] != data_page) {
+      arena->Map(address, data_page);
+    }
+
+    (*code_pagetable)[index] = code_page;
+    (*data_pagetable)[index] = data_page;
+    (*cpu_write_pagetable)[index] = cpu_write_page;
+  }
+
+  if (arena != nullptr && !arena->Flush()) {
+    LOG_WARN("ARM9: failed to update the fast memory arena, falling back to the pagetable.");
+    arena = nullptr;
+    arena_base = nullptr;
+    arena_region_map = nullptr;
+  }
+
+  OnMemoryMapChanged();
+}
+
+void ARM9MemoryBus::UpdateMemoryMap(TCM::Config const& config) {
+  if (config.enable || config.enable_read) {
+    UpdateMemoryMap(config.base, u64(config.limit) + 1);
+  }
+}
+
+void ARM9MemoryBus::SetDTCM(TCM::Config const& config) {
+  auto old_config = dtcm.config;
+  dtcm.config = config;
+
+  if (gEnableFastMemory && config != old_config) {
+    UpdateMemoryMap(old_config);
+    UpdateMemoryMap(config);
   }
 }
 
+void ARM9MemoryBus::SetITCM(TCM::Config const& config) {
+  auto old_config = itcm.config;
+  itcm.config = config;
+
+  if (gEnableFastMemory && config != old_config) {
+    UpdateMemoryMap(old_config);
+    UpdateMemoryMap(config);
+  }
+}
+
+void ARM9MemoryBus::LoadState(StateReader& state) {
+  state.Read(itcm_data, 0x8000);
+  state.Read(dtcm_data, 0x4000);
+}
+
+void ARM9MemoryBus::SaveState(StateWriter& state) {
+  state.Write(itcm_data, 0x8000);
+  state.Write(dtcm_data, 0x4000);
+}
+
 template <typename T>
 auto ARM9MemoryBus::Read(u32 address, Bus bus) -> T {
   static_assert(common::is_one_of_v<T, u8, u16, u32, u64>, "T must be u8, u16, u32 or u64");
@@ -126,20 +236,14 @@ auto ARM9MemoryBus::Read(u32 address, Bus bus) -> T {
       return read<T>(swram.data, address & swram.mask);
     }
     case 0x04: {
+      auto guard = cpu_sync.LockIO();
+      cpu_sync.OnIOAccess(address);
       if constexpr (std::is_same<T, u64>::value) {
-        return ReadWordIO(address | 0) |
-          (u64(ReadWordIO(address | 4)) << 32);
-      }
-      if constexpr (std::is_same<T, u32>::value) {
-        return ReadWordIO(address);
+        return mmio.Read<u32>(address | 0) |
+          (u64(mmio.Read<u32>(address | 4)) << 32);
+      } else {
+        return mmio.Read<T>(address);
       }
-      if constexpr (std::is_same<T, u16>::value) {
-        return ReadHalfIO(address);
-      }
-      if constexpr (std::is_same<T, u8>::value) {
-        return ReadByteIO(address);
-      }
-      return 0;
     }
     case 0x05: {
       return read<T>(video_unit.pram, address & 0x7FF);
@@ -189,6 +293,7 @@ void ARM9MemoryBus::Write(u32 address, T value, Bus bus) {
   switch (address >> 24) {
     case 0x02: {
       write<T>(ewram, address & 0x3FFFFF, value);
+      dirty_pages.Mark(&ewram[address & 0x3FFFFF]);
       break;
     }
     case 0x03: {
@@ -197,26 +302,22 @@ void ARM9MemoryBus::Write(u32 address, T value, Bus bus) {
         return;
       }
       write<T>(swram.data, address & swram.mask, value);
+      dirty_pages.Mark(&swram.data[address & swram.mask]);
       break;
     }
     case 0x04: {
+      auto guard = cpu_sync.LockIO();
+      cpu_sync.OnIOAccess(address);
       if constexpr (std::is_same<T, u64>::value) {
-        WriteWordIO(address | 0, value);
-        WriteWordIO(address | 4, value >> 32);
-      }
-      if constexpr (std::is_same<T, u32>::value) {
-        WriteWordIO(address, value);
-      }
-      if constexpr (std::is_same<T, u16>::value) {
-        WriteHalfIO(address, value);
-      }
-      if constexpr (std::is_same<T, u8>::value) {
-        WriteByteIO(address, value);
+        mmio.Write<u32>(address | 0, value);
+        mmio.Write<u32>(address | 4, value >> 32);
+      } else {
+        mmio.Write<T>(address, value);
       }
       break;
     }
     case 0x05: {
-      write<T>(video_unit.pram, address & 0x7FF, value);
+      video_unit.WritePRAM<T>(address, value);
       break;
     }
     case 0x06: {
@@ -224,7 +325,7 @@ void ARM9MemoryBus::Write(u32 address, T value, Bus bus) {
       break;
     }
     case 0x07: {
-      write<T>(video_unit.oam, address & 0x7FF, value);
+      video_unit.WriteOAM<T>(address, value);
       break;
     }
     default: {
@@ -9,14 +9,15 @@
 
 #include "arm/memory.hpp"
 #include "interconnect.hpp"
+#include "mmio.hpp"
 
 namespace Duality::Core {
 
 struct ARM9MemoryBus final : arm::MemoryBase {
   ARM9MemoryBus(Interconnect* interconnect);
 
-  void SetDTCM(TCM::Config const& config) { dtcm.config = config; }
-  void SetITCM(TCM::Config const& config) { itcm.config = config; }
+  void SetDTCM(TCM::Config const& config);
+  void SetITCM(TCM::Config const& config);
 
   auto ReadByte(u32 address, Bus bus) ->  u8 override;
   auto ReadHalf(u32 address, Bus bus) -> u16 override;
@@ -28,8 +29,12 @@ struct ARM9MemoryBus final : arm::MemoryBase {
   void WriteWord(u32 address, u32 value, Bus bus) override;
   void WriteQuad(u32 address, u64 value, Bus bus) override;
 
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
+
 private:
   void UpdateMemoryMap(u32 address_lo, u64 address_hi);
+  void UpdateMemoryMap(TCM::Config const& config);
 
   template<typename T>
   auto Read(u32 address, Bus bus) -> T;
@@ -76,18 +81,19 @@ private:
     };
   };
 
-  auto ReadByteIO(u32 address) ->  u8;
-  auto ReadHalfIO(u32 address) -> u16;
-  auto ReadWordIO(u32 address) -> u32;
-
-  void WriteByteIO(u32 address,  u8 value);
-  void WriteHalfIO(u32 address, u16 value);
-  void WriteWordIO(u32 address, u32 value);
+  void SetupMMIO();
+  void SetupPPUMMIO(u32 base, PPU::MMIO& ppu_io);
+  void SetupMathEngineMMIO();
 
   /// ARM9 internal memory
-  u8 bios[0x8000] {0};
-  u8 dtcm_data[0x4000] {0};
-  u8 itcm_data[0x8000] {0};
+  u8* bios;
+  u8* dtcm_data;
+  u8* itcm_data;
+
+  /// Pagetables with the TCMs folded in (see MemoryBase::code_pagetable)
+  std::unique_ptr<PageTable> code_pagetable_tcm;
+  std::unique_ptr<PageTable> data_pagetable_tcm;
+  std::unique_ptr<PageTable> cpu_write_pagetable_tcm;
 
   /// ARM7 and ARM9 shared memory
   u8* ewram;
@@ -103,7 +109,12 @@ private:
   VideoUnit& video_unit;
   VRAM& vram;
   Interconnect::WRAMCNT& wramcnt;
+  CPUSync& cpu_sync;
   Interconnect::KeyInput& keyinput;
+  DirtyPageTracker& dirty_pages;
+
+  /// I/O register handlers
+  MMIO mmio {"ARM9"};
 };
 
 } // namespace Duality::Core
@@ -174,1556 +174,204 @@ enum Registers {
   REG_CLIPMTX_RESULT_HI = 0x0400'067F
 };
 
-auto ARM9MemoryBus::ReadByteIO(u32 address) -> u8 {
-  auto& gpu_io = video_unit.gpu;
-  auto& ppu_io_a = video_unit.ppu_a.mmio;
-  auto& ppu_io_b = video_unit.ppu_b.mmio;
-
-  switch (address) {
-    // PPU engine A
-    case REG_DISPCNT_A|0:
-      return ppu_io_a.dispcnt.ReadByte(0);
-    case REG_DISPCNT_A|1:
-      return ppu_io_a.dispcnt.ReadByte(1);
-    case REG_DISPCNT_A|2:
-      return ppu_io_a.dispcnt.ReadByte(2);
-    case REG_DISPCNT_A|3:
-      return ppu_io_a.dispcnt.ReadByte(3);
-    case REG_DISPSTAT|0:
-      return video_unit.dispstat9.ReadByte(0);
-    case REG_DISPSTAT|1:
-      return video_unit.dispstat9.ReadByte(1);
-    case REG_VCOUNT|0:
-      return video_unit.vcount.ReadByte(0);
-    case REG_VCOUNT|1:
-      return video_unit.vcount.ReadByte(1);
-    case REG_BG0CNT_A|0:
-      return ppu_io_a.bgcnt[0].ReadByte(0);
-    case REG_BG0CNT_A|1:
-      return ppu_io_a.bgcnt[0].ReadByte(1);
-    case REG_BG1CNT_A|0:
-      return ppu_io_a.bgcnt[1].ReadByte(0);
-    case REG_BG1CNT_A|1:
-      return ppu_io_a.bgcnt[1].ReadByte(1);
-    case REG_BG2CNT_A|0:
-      return ppu_io_a.bgcnt[2].ReadByte(0);
-    case REG_BG2CNT_A|1:
-      return ppu_io_a.bgcnt[2].ReadByte(1);
-    case REG_BG3CNT_A|0:
-      return ppu_io_a.bgcnt[3].ReadByte(0);
-    case REG_BG3CNT_A|1:
-      return ppu_io_a.bgcnt[3].ReadByte(1);
-    case REG_WININ_A|0:
-      return ppu_io_a.winin.ReadByte(0);
-    case REG_WININ_A|1:
-      return ppu_io_a.winin.ReadByte(1);
-    case REG_WINOUT_A|0:
-      return ppu_io_a.winout.ReadByte(0);
-    case REG_WINOUT_A|1:
-      return ppu_io_a.winout.ReadByte(1);
-    case REG_BLDCNT_A|0:
-      return ppu_io_a.bldcnt.ReadByte(0);
-    case REG_BLDCNT_A|1:
-      return ppu_io_a.bldcnt.ReadByte(1);
-    case REG_BLDALPHA_A|0:
-      return ppu_io_a.bldalpha.ReadByte(0);
-    case REG_BLDALPHA_A|1:
-      return ppu_io_a.bldalpha.ReadByte(1);
-
-    // PPU engine B
-    case REG_DISPCNT_B|0:
-      return ppu_io_b.dispcnt.ReadByte(0);
-    case REG_DISPCNT_B|1:
-      return ppu_io_b.dispcnt.ReadByte(1);
-    case REG_DISPCNT_B|2:
-      return ppu_io_b.dispcnt.ReadByte(2);
-    case REG_DISPCNT_B|3:
-      return ppu_io_b.dispcnt.ReadByte(3);
-    case REG_BG0CNT_B|0:
-      return ppu_io_b.bgcnt[0].ReadByte(0);
-    case REG_BG0CNT_B|1:
-      return ppu_io_b.bgcnt[0].ReadByte(1);
-    case REG_BG1CNT_B|0:
-      return ppu_io_b.bgcnt[1].ReadByte(0);
-    case REG_BG1CNT_B|1:
-      return ppu_io_b.bgcnt[1].ReadByte(1);
-    case REG_BG2CNT_B|0:
-      return ppu_io_b.bgcnt[2].ReadByte(0);
-    case REG_BG2CNT_B|1:
-      return ppu_io_b.bgcnt[2].ReadByte(1);
-    case REG_BG3CNT_B|0:
-      return ppu_io_b.bgcnt[3].ReadByte(0);
-    case REG_BG3CNT_B|1:
-      return ppu_io_b.bgcnt[3].ReadByte(1);
-    case REG_WININ_B|0:
-      return ppu_io_b.winin.ReadByte(0);
-    case REG_WININ_B|1:
-      return ppu_io_b.winin.ReadByte(1);
-    case REG_WINOUT_B|0:
-      return ppu_io_b.winout.ReadByte(0);
-    case REG_WINOUT_B|1:
-      return ppu_io_b.winout.ReadByte(1);
-    case REG_BLDCNT_B|0:
-      return ppu_io_b.bldcnt.ReadByte(0);
-    case REG_BLDCNT_B|1:
-      return ppu_io_b.bldcnt.ReadByte(1);
-    case REG_BLDALPHA_B|0:
-      return ppu_io_b.bldalpha.ReadByte(0);
-    case REG_BLDALPHA_B|1:
-      return ppu_io_b.bldalpha.ReadByte(1);
-    
-    // DMA
-    case REG_DMA0SAD|0:
-      return dma.Read(0, 0);
-    case REG_DMA0SAD|1:
-      return dma.Read(0, 1);
-    case REG_DMA0SAD|2:
-      return dma.Read(0, 2);
-    case REG_DMA0SAD|3:
-      return dma.Read(0, 3);
-    case REG_DMA0DAD|0:
-      return dma.Read(0, 4);
-    case REG_DMA0DAD|1:
-      return dma.Read(0, 5);
-    case REG_DMA0DAD|2:
-      return dma.Read(0, 6);
-    case REG_DMA0DAD|3:
-      return dma.Read(0, 7);
-    case REG_DMA0CNT_L|0:
-      return dma.Read(0, 8);
-    case REG_DMA0CNT_L|1:
-      return dma.Read(0, 9);
-    case REG_DMA0CNT_H|0:
-      return dma.Read(0, 10);
-    case REG_DMA0CNT_H|1:
-      return dma.Read(0, 11);
-    case REG_DMA1SAD|0:
-      return dma.Read(1, 0);
-    case REG_DMA1SAD|1:
-      return dma.Read(1, 1);
-    case REG_DMA1SAD|2:
-      return dma.Read(1, 2);
-    case REG_DMA1SAD|3:
-      return dma.Read(1, 3);
-    case REG_DMA1DAD|0:
-      return dma.Read(1, 4);
-    case REG_DMA1DAD|1:
-      return dma.Read(1, 5);
-    case REG_DMA1DAD|2:
-      return dma.Read(1, 6);
-    case REG_DMA1DAD|3:
-      return dma.Read(1, 7);
-    case REG_DMA1CNT_L|0:
-      return dma.Read(1, 8);
-    case REG_DMA1CNT_L|1:
-      return dma.Read(1, 9);
-    case REG_DMA1CNT_H|0:
-      return dma.Read(1, 10);
-    case REG_DMA1CNT_H|1:
-      return dma.Read(1, 11);
-    case REG_DMA2SAD|0:
-      return dma.Read(2, 0);
-    case REG_DMA2SAD|1:
-      return dma.Read(2, 1);
-    case REG_DMA2SAD|2:
-      return dma.Read(2, 2);
-    case REG_DMA2SAD|3:
-      return dma.Read(2, 3);
-    case REG_DMA2DAD|0:
-      return dma.Read(2, 4);
-    case REG_DMA2DAD|1:
-      return dma.Read(2, 5);
-    case REG_DMA2DAD|2:
-      return dma.Read(2, 6);
-    case REG_DMA2DAD|3:
-      return dma.Read(2, 7);
-    case REG_DMA2CNT_L|0:
-      return dma.Read(2, 8);
-    case REG_DMA2CNT_L|1:
-      return dma.Read(2, 9);
-    case REG_DMA2CNT_H|0:
-      return dma.Read(2, 10);
-    case REG_DMA2CNT_H|1:
-      return dma.Read(2, 11);
-    case REG_DMA3SAD|0:
-      return dma.Read(3, 0);
-    case REG_DMA3SAD|1:
-      return dma.Read(3, 1);
-    case REG_DMA3SAD|2:
-      return dma.Read(3, 2);
-    case REG_DMA3SAD|3:
-      return dma.Read(3, 3);
-    case REG_DMA3DAD|0:
-      return dma.Read(3, 4);
-    case REG_DMA3DAD|1:
-      return dma.Read(3, 5);
-    case REG_DMA3DAD|2:
-      return dma.Read(3, 6);
-    case REG_DMA3DAD|3:
-      return dma.Read(3, 7);
-    case REG_DMA3CNT_L|0:
-      return dma.Read(3, 8);
-    case REG_DMA3CNT_L|1:
-      return dma.Read(3, 9);
-    case REG_DMA3CNT_H|0:
-      return dma.Read(3, 10);
-    case REG_DMA3CNT_H|1:
-      return dma.Read(3, 11);
-    case REG_DMA0FILL|0:
-      return dma.ReadFill(0);
-    case REG_DMA0FILL|1:
-      return dma.ReadFill(1);
-    case REG_DMA0FILL|2:
-      return dma.ReadFill(2);
-    case REG_DMA0FILL|3:
-      return dma.ReadFill(3);
-    case REG_DMA1FILL|0:
-      return dma.ReadFill(4);
-    case REG_DMA1FILL|1:
-      return dma.ReadFill(5);
-    case REG_DMA1FILL|2:
-      return dma.ReadFill(6);
-    case REG_DMA1FILL|3:
-      return dma.ReadFill(7);
-    case REG_DMA2FILL|0:
-      return dma.ReadFill(8);
-    case REG_DMA2FILL|1:
-      return dma.ReadFill(9);
-    case REG_DMA2FILL|2:
-      return dma.ReadFill(10);
-    case REG_DMA2FILL|3:
-      return dma.ReadFill(11);
-    case REG_DMA3FILL|0:
-      return dma.ReadFill(12);
-    case REG_DMA3FILL|1:
-      return dma.ReadFill(13);
-    case REG_DMA3FILL|2:
-      return dma.ReadFill(14);
-    case REG_DMA3FILL|3:
-      return dma.ReadFill(15);
-
-    // Timers
-    case REG_TM0CNT_L|0:
-      return timer.Read(0, 0);
-    case REG_TM0CNT_L|1:
-      return timer.Read(0, 1);
-    case REG_TM0CNT_H|0:
-      return timer.Read(0, 2);
-    case REG_TM0CNT_H|1:
-      return timer.Read(0, 3);
-    case REG_TM1CNT_L|0:
-      return timer.Read(1, 0);
-    case REG_TM1CNT_L|1:
-      return timer.Read(1, 1);
-    case REG_TM1CNT_H|0:
-      return timer.Read(1, 2);
-    case REG_TM1CNT_H|1:
-      return timer.Read(1, 3);
-    case REG_TM2CNT_L|0:
-      return timer.Read(2, 0);
-    case REG_TM2CNT_L|1:
-      return timer.Read(2, 1);
-    case REG_TM2CNT_H|0:
-      return timer.Read(2, 2);
-    case REG_TM2CNT_H|1:
-      return timer.Read(2, 3);
-    case REG_TM3CNT_L|0:
-      return timer.Read(3, 0);
-    case REG_TM3CNT_L|1:
-      return timer.Read(3, 1);
-    case REG_TM3CNT_H|0:
-      return timer.Read(3, 2);
-    case REG_TM3CNT_H|1:
-      return timer.Read(3, 3);
-
-    // Input
-    case REG_KEYINPUT|0:
-      return keyinput.ReadByte(0);
-    case REG_KEYINPUT|1:
-      return keyinput.ReadByte(1);
-
-    // IPC
-    case REG_IPCSYNC|0:
-      return ipc.ipcsync.ReadByte(IPC::Client::ARM9, 0);
-    case REG_IPCSYNC|1:
-      return ipc.ipcsync.ReadByte(IPC::Client::ARM9, 1);
-    case REG_IPCFIFOCNT|0:
-      return ipc.ipcfifocnt.ReadByte(IPC::Client::ARM9, 0);
-    case REG_IPCFIFOCNT|1:
-      return ipc.ipcfifocnt.ReadByte(IPC::Client::ARM9, 1);
-    case REG_IPCFIFORECV|0:
-      return ipc.ipcfiforecv.ReadByte(IPC::Client::ARM9, 0);
-    case REG_IPCFIFORECV|1:
-      return ipc.ipcfiforecv.ReadByte(IPC::Client::ARM9, 1);
-    case REG_IPCFIFORECV|2:
-      return ipc.ipcfiforecv.ReadByte(IPC::Client::ARM9, 2);
-    case REG_IPCFIFORECV|3:
-      return ipc.ipcfiforecv.ReadByte(IPC::Client::ARM9, 3);
-
-    // Cartridge interface
-    case REG_AUXSPICNT|0:
-      return cart.auxspicnt.ReadByte(0);
-    case REG_AUXSPICNT|1:
-      return cart.auxspicnt.ReadByte(1);
-    case REG_AUXSPIDATA|0:
-      return cart.ReadSPI();
-    case REG_AUXSPIDATA|1:
-      return 0;
-    case REG_ROMCTRL|0:
-      return cart.romctrl.ReadByte(0);
-    case REG_ROMCTRL|1:
-      return cart.romctrl.ReadByte(1);
-    case REG_ROMCTRL|2:
-      return cart.romctrl.ReadByte(2);
-    case REG_ROMCTRL|3:
-      return cart.romctrl.ReadByte(3);
-    case REG_CARDCMD|0:
-      return cart.cardcmd.ReadByte(0);
-    case REG_CARDCMD|1:
-      return cart.cardcmd.ReadByte(1);
-    case REG_CARDCMD|2:
-      return cart.cardcmd.ReadByte(2);
-    case REG_CARDCMD|3:
-      return cart.cardcmd.ReadByte(3);
-    case REG_CARDCMD|4:
-      return cart.cardcmd.ReadByte(4);
-    case REG_CARDCMD|5:
-      return cart.cardcmd.ReadByte(5);
-    case REG_CARDCMD|6:
-      return cart.cardcmd.ReadByte(6);
-    case REG_CARDCMD|7:
-      return cart.cardcmd.ReadByte(7);
-    case REG_CARDDATA|0:
-    case REG_CARDDATA|1:
-    case REG_CARDDATA|2:
-    case REG_CARDDATA|3:
-      ASSERT(false, "ARM9: unhandled byte read from REG_CARDDATA");
-      return 0;
-
-    // IRQ
-    case REG_IME|0:
-      return irq9.ime.ReadByte(0);
-    case REG_IME|1:
-      return irq9.ime.ReadByte(1);
-    case REG_IME|2:
-      return irq9.ime.ReadByte(2);
-    case REG_IME|3:
-      return irq9.ime.ReadByte(3);
-    case REG_IE|0:
-      return irq9.ie.ReadByte(0);
-    case REG_IE|1:
-      return irq9.ie.ReadByte(1);
-    case REG_IE|2:
-      return irq9.ie.ReadByte(2);
-    case REG_IE|3:
-      return irq9.ie.ReadByte(3);
-    case REG_IF|0:
-      return irq9._if.ReadByte(0);
-    case REG_IF|1:
-      return irq9._if.ReadByte(1);
-    case REG_IF|2:
-      return irq9._if.ReadByte(2);
-    case REG_IF|3:
-      return irq9._if.ReadByte(3);
-
-    case REG_WRAMCNT:
-      return wramcnt.ReadByte();
-
-    // Math engine
-    case REG_DIVCNT|0:
-      return math_engine.divcnt.ReadByte(0);
-    case REG_DIVCNT|1:
-      return math_engine.divcnt.ReadByte(1);
-    case REG_DIV_NUMER|0:
-      return math_engine.div_numer.ReadByte(0);
-    case REG_DIV_NUMER|1:
-      return math_engine.div_numer.ReadByte(1);
-    case REG_DIV_NUMER|2:
-      return math_engine.div_numer.ReadByte(2);
-    case REG_DIV_NUMER|3:
-      return math_engine.div_numer.ReadByte(3);
-    case REG_DIV_NUMER|4:
-      return math_engine.div_numer.ReadByte(4);
-    case REG_DIV_NUMER|5:
-      return math_engine.div_numer.ReadByte(5);
-    case REG_DIV_NUMER|6:
-      return math_engine.div_numer.ReadByte(6);
-    case REG_DIV_NUMER|7:
-      return math_engine.div_numer.ReadByte(7);
-    case REG_DIV_DENOM|0:
-      return math_engine.div_denom.ReadByte(0);
-    case REG_DIV_DENOM|1:
-      return math_engine.div_denom.ReadByte(1);
-    case REG_DIV_DENOM|2:
-      return math_engine.div_denom.ReadByte(2);
-    case REG_DIV_DENOM|3:
-      return math_engine.div_denom.ReadByte(3);
-    case REG_DIV_DENOM|4:
-      return math_engine.div_denom.ReadByte(4);
-    case REG_DIV_DENOM|5:
-      return math_engine.div_denom.ReadByte(5);
-    case REG_DIV_DENOM|6:
-      return math_engine.div_denom.ReadByte(6);
-    case REG_DIV_DENOM|7:
-      return math_engine.div_denom.ReadByte(7);
-    case REG_DIV_RESULT|0:
-      return math_engine.div_result.ReadByte(0);
-    case REG_DIV_RESULT|1:
-      return math_engine.div_result.ReadByte(1);
-    case REG_DIV_RESULT|2:
-      return math_engine.div_result.ReadByte(2);
-    case REG_DIV_RESULT|3:
-      return math_engine.div_result.ReadByte(3);
-    case REG_DIV_RESULT|4:
-      return math_engine.div_result.ReadByte(4);
-    case REG_DIV_RESULT|5:
-      return math_engine.div_result.ReadByte(5);
-    case REG_DIV_RESULT|6:
-      return math_engine.div_result.ReadByte(6);
-    case REG_DIV_RESULT|7:
-      return math_engine.div_result.ReadByte(7);
-    case REG_DIVREM_RESULT|0:
-      return math_engine.div_remain.ReadByte(0);
-    case REG_DIVREM_RESULT|1:
-      return math_engine.div_remain.ReadByte(1);
-    case REG_DIVREM_RESULT|2:
-      return math_engine.div_remain.ReadByte(2);
-    case REG_DIVREM_RESULT|3:
-      return math_engine.div_remain.ReadByte(3);
-    case REG_DIVREM_RESULT|4:
-      return math_engine.div_remain.ReadByte(4);
-    case REG_DIVREM_RESULT|5:
-      return math_engine.div_remain.ReadByte(5);
-    case REG_DIVREM_RESULT|6:
-      return math_engine.div_remain.ReadByte(6);
-    case REG_DIVREM_RESULT|7:
-      return math_engine.div_remain.ReadByte(7);
-    case REG_SQRTCNT|0:
-      return math_engine.sqrtcnt.ReadByte(0);
-    case REG_SQRTCNT|1:
-      return math_engine.sqrtcnt.ReadByte(1);
-    case REG_SQRT_RESULT|0:
-      return math_engine.sqrt_result.ReadByte(0);
-    case REG_SQRT_RESULT|1:
-      return math_engine.sqrt_result.ReadByte(1);
-    case REG_SQRT_RESULT|2:
-      return math_engine.sqrt_result.ReadByte(2);
-    case REG_SQRT_RESULT|3:
-      return math_engine.sqrt_result.ReadByte(3);
-    case REG_SQRT_PARAM|0:
-      return math_engine.sqrt_param.ReadByte(0);
-    case REG_SQRT_PARAM|1:
-      return math_engine.sqrt_param.ReadByte(1);
-    case REG_SQRT_PARAM|2:
-      return math_engine.sqrt_param.ReadByte(2);
-    case REG_SQRT_PARAM|3:
-      return math_engine.sqrt_param.ReadByte(3);
-    case REG_SQRT_PARAM|4:
-      return math_engine.sqrt_param.ReadByte(4);
-    case REG_SQRT_PARAM|5:
-      return math_engine.sqrt_param.ReadByte(5);
-    case REG_SQRT_PARAM|6:
-      return math_engine.sqrt_param.ReadByte(6);
-    case REG_SQRT_PARAM|7:
-      return math_engine.sqrt_param.ReadByte(7);
-      
-    // GPU
-    case REG_DISP3DCNT|0:
-      return gpu_io.disp3dcnt.ReadByte(0);
-    case REG_DISP3DCNT|1:
-      return gpu_io.disp3dcnt.ReadByte(1);
-    case REG_POWCNT1|0:
-      return video_unit.powcnt1.ReadByte(0);
-    case REG_POWCNT1|1:
-      return video_unit.powcnt1.ReadByte(1);
-    case REG_GXSTAT|0:
-      return gpu_io.gxstat.ReadByte(0);
-    case REG_GXSTAT|1:
-      return gpu_io.gxstat.ReadByte(1);
-    case REG_GXSTAT|2:
-      return gpu_io.gxstat.ReadByte(2);
-    case REG_GXSTAT|3:
-      return gpu_io.gxstat.ReadByte(3);
-    case REG_CLIPMTX_RESULT_LO ... REG_CLIPMTX_RESULT_HI:
-      return gpu_io.ReadClipMatrix<u8>(address - REG_CLIPMTX_RESULT_LO);
 
-    case REG_POSTFLG:
-      return 1;
-
-    default:
-      LOG_WARN("ARM9: MMIO: unhandled read from 0x{0:08X}", address);
-  }
-
-  return 0;
-}
-
-auto ARM9MemoryBus::ReadHalfIO(u32 address) -> u16 {
+void ARM9MemoryBus::SetupMMIO() {
   auto& gpu_io = video_unit.gpu;
 
-  switch (address) {
-    case REG_IPCFIFORECV|0:
-      return ipc.ipcfiforecv.ReadHalf(IPC::Client::ARM9, 0);
-    case REG_IPCFIFORECV|2:
-      return ipc.ipcfiforecv.ReadHalf(IPC::Client::ARM9, 2);
-    case REG_CLIPMTX_RESULT_LO ... REG_CLIPMTX_RESULT_HI:
-      return gpu_io.ReadClipMatrix<u16>(address - REG_CLIPMTX_RESULT_LO);
-  }
-
-  return (ReadByteIO(address | 0) << 0) |
-         (ReadByteIO(address | 1) << 8);
-}
-
-auto ARM9MemoryBus::ReadWordIO(u32 address) -> u32 {
-  auto& gpu_io = video_unit.gpu;
+  // PPU
+  SetupPPUMMIO(REG_DISPCNT_A, video_unit.ppu_a.mmio);
+  SetupPPUMMIO(REG_DISPCNT_B, video_unit.ppu_b.mmio);
+  mmio.MapRegister<u16>(REG_DISPSTAT, video_unit.dispstat9);
+  mmio.MapReadRegister<u16>(REG_VCOUNT, video_unit.vcount);
 
-  switch (address) {
-    case REG_IPCFIFORECV:
-      return ipc.ipcfiforecv.ReadWord(IPC::Client::ARM9);
-    case REG_CARDDATA:
-      return cart.ReadROM();
-    case REG_CLIPMTX_RESULT_LO ... REG_CLIPMTX_RESULT_HI:
-      return gpu_io.ReadClipMatrix<u32>(address - REG_CLIPMTX_RESULT_LO);
+  // DMA
+  for (uint chan = 0; chan < 4; chan++) {
+    for (uint reg = 0; reg < 12; reg += 4) {
+      auto address = REG_DMA0SAD + chan * 12 + reg;
+      mmio.MapReadBytes<u32>(address, [this, chan, reg](uint offset) {
+        return dma.Read(chan, reg | offset);
+      });
+      mmio.MapWriteBytes<u32>(address, [this, chan, reg](uint offset, u8 value) {
+        dma.Write(chan, reg | offset, value);
+      });
+    }
+    mmio.MapReadBytes<u32>(REG_DMA0FILL + chan * 4, [this, chan](uint offset) {
+      return dma.ReadFill(chan * 4 + offset);
+    });
+    mmio.MapWriteBytes<u32>(REG_DMA0FILL + chan * 4, [this, chan](uint offset, u8 value) {
+      dma.WriteFill(chan * 4 + offset, value);
+    });
   }
 
-  return (ReadByteIO(address | 0) <<  0) |
-         (ReadByteIO(address | 1) <<  8) |
-         (ReadByteIO(address | 2) << 16) |
-         (ReadByteIO(address | 3) << 24);
-}
+  // Timers
+  for (uint chan = 0; chan < 4; chan++) {
+    mmio.MapReadBytes<u32>(REG_TM0CNT_L + chan * 4, [this, chan](uint offset) {
+      return timer.Read(chan, offset);
+    });
+    mmio.MapWriteBytes<u32>(REG_TM0CNT_L + chan * 4, [this, chan](uint offset, u8 value) {
+      timer.Write(chan, offset, value);
+    });
+  }
 
-void ARM9MemoryBus::WriteByteIO(u32 address,  u8 value) {
-  auto& gpu_io = video_unit.gpu;
-  auto& ppu_io_a = video_unit.ppu_a.mmio;
-  auto& ppu_io_b = video_unit.ppu_b.mmio;
+  // Input
+  mmio.MapReadRegister<u16>(REG_KEYINPUT, keyinput);
 
-  switch (address) {
-    // PPU engine A
-    case REG_DISPCNT_A|0:
-      ppu_io_a.dispcnt.WriteByte(0, value);
-      break;
-    case REG_DISPCNT_A|1:
-      ppu_io_a.dispcnt.WriteByte(1, value);
-      break;
-    case REG_DISPCNT_A|2:
-      ppu_io_a.dispcnt.WriteByte(2, value);
-      break;
-    case REG_DISPCNT_A|3:
-      ppu_io_a.dispcnt.WriteByte(3, value);
-      break;
-    case REG_DISPSTAT|0:
-      video_unit.dispstat9.WriteByte(0, value);
-      break;
-    case REG_DISPSTAT|1:
-      video_unit.dispstat9.WriteByte(1, value);
-      break;
-    case REG_BG0CNT_A|0:
-      ppu_io_a.bgcnt[0].WriteByte(0, value);
-      break;
-    case REG_BG0CNT_A|1:
-      ppu_io_a.bgcnt[0].WriteByte(1, value);
-      break;
-    case REG_BG1CNT_A|0:
-      ppu_io_a.bgcnt[1].WriteByte(0, value);
-      break;
-    case REG_BG1CNT_A|1:
-      ppu_io_a.bgcnt[1].WriteByte(1, value);
-      break;
-    case REG_BG2CNT_A|0:
-      ppu_io_a.bgcnt[2].WriteByte(0, value);
-      break;
-    case REG_BG2CNT_A|1:
-      ppu_io_a.bgcnt[2].WriteByte(1, value);
-      break;
-    case REG_BG3CNT_A|0:
-      ppu_io_a.bgcnt[3].WriteByte(0, value);
-      break;
-    case REG_BG3CNT_A|1:
-      ppu_io_a.bgcnt[3].WriteByte(1, value);
-      break;
-    case REG_BG0HOFS_A|0:
-      ppu_io_a.bghofs[0].WriteByte(0, value);
-      break;
-    case REG_BG0HOFS_A|1:
-      ppu_io_a.bghofs[0].WriteByte(1, value);
-      break;
-    case REG_BG0VOFS_A|0:
-      ppu_io_a.bgvofs[0].WriteByte(0, value);
-      break;
-    case REG_BG0VOFS_A|1:
-      ppu_io_a.bgvofs[0].WriteByte(1, value);
-      break;
-    case REG_BG1HOFS_A|0:
-      ppu_io_a.bghofs[1].WriteByte(0, value);
-      break;
-    case REG_BG1HOFS_A|1:
-      ppu_io_a.bghofs[1].WriteByte(1, value);
-      break;
-    case REG_BG1VOFS_A|0:
-      ppu_io_a.bgvofs[1].WriteByte(0, value);
-      break;
-    case REG_BG1VOFS_A|1:
-      ppu_io_a.bgvofs[1].WriteByte(1, value);
-      break;
-    case REG_BG2HOFS_A|0:
-      ppu_io_a.bghofs[2].WriteByte(0, value);
-      break;
-    case REG_BG2HOFS_A|1:
-      ppu_io_a.bghofs[2].WriteByte(1, value);
-      break;
-    case REG_BG2VOFS_A|0:
-      ppu_io_a.bgvofs[2].WriteByte(0, value);
-      break;
-    case REG_BG2VOFS_A|1:
-      ppu_io_a.bgvofs[2].WriteByte(1, value);
-      break;
-    case REG_BG3HOFS_A|0:
-      ppu_io_a.bghofs[3].WriteByte(0, value);
-      break;
-    case REG_BG3HOFS_A|1:
-      ppu_io_a.bghofs[3].WriteByte(1, value);
-      break;
-    case REG_BG3VOFS_A|0:
-      ppu_io_a.bgvofs[3].WriteByte(0, value);
-      break;
-    case REG_BG3VOFS_A|1:
-      ppu_io_a.bgvofs[3].WriteByte(1, value);
-      break;    
-    case REG_BG2PA_A|0:
-      ppu_io_a.bgpa[0].WriteByte(0, value);
-      break;
-    case REG_BG2PA_A|1:
-      ppu_io_a.bgpa[0].WriteByte(1, value);
-      break;
-    case REG_BG2PB_A|0:
-      ppu_io_a.bgpb[0].WriteByte(0, value);
-      break;
-    case REG_BG2PB_A|1:
-      ppu_io_a.bgpb[0].WriteByte(1, value);
-      break;
-    case REG_BG2PC_A|0:
-      ppu_io_a.bgpc[0].WriteByte(0, value);
-      break;
-    case REG_BG2PC_A|1:
-      ppu_io_a.bgpc[0].WriteByte(1, value);
-      break;
-    case REG_BG2PD_A|0:
-      ppu_io_a.bgpd[0].WriteByte(0, value);
-      break;
-    case REG_BG2PD_A|1:
-      ppu_io_a.bgpd[0].WriteByte(1, value);
-      break;
-    case REG_BG2X_A|0:
-      ppu_io_a.bgx[0].WriteByte(0, value);
-      break;
-    case REG_BG2X_A|1:
-      ppu_io_a.bgx[0].WriteByte(1, value);
-      break;
-    case REG_BG2X_A|2:
-      ppu_io_a.bgx[0].WriteByte(2, value);
-      break;
-    case REG_BG2X_A|3:
-      ppu_io_a.bgx[0].WriteByte(3, value);
-      break;
-    case REG_BG2Y_A|0:
-      ppu_io_a.bgy[0].WriteByte(0, value);
-      break;
-    case REG_BG2Y_A|1:
-      ppu_io_a.bgy[0].WriteByte(1, value);
-      break;
-    case REG_BG2Y_A|2:
-      ppu_io_a.bgy[0].WriteByte(2, value);
-      break;
-    case REG_BG2Y_A|3:
-      ppu_io_a.bgy[0].WriteByte(3, value);
-      break;
-    case REG_BG3PA_A|0:
-      ppu_io_a.bgpa[1].WriteByte(0, value);
-      break;
-    case REG_BG3PA_A|1:
-      ppu_io_a.bgpa[1].WriteByte(1, value);
-      break;
-    case REG_BG3PB_A|0:
-      ppu_io_a.bgpb[1].WriteByte(0, value);
-      break;
-    case REG_BG3PB_A|1:
-      ppu_io_a.bgpb[1].WriteByte(1, value);
-      break;
-    case REG_BG3PC_A|0:
-      ppu_io_a.bgpc[1].WriteByte(0, value);
-      break;
-    case REG_BG3PC_A|1:
-      ppu_io_a.bgpc[1].WriteByte(1, value);
-      break;
-    case REG_BG3PD_A|0:
-      ppu_io_a.bgpd[1].WriteByte(0, value);
-      break;
-    case REG_BG3PD_A|1:
-      ppu_io_a.bgpd[1].WriteByte(1, value);
-      break;
-    case REG_BG3X_A|0:
-      ppu_io_a.bgx[1].WriteByte(0, value);
-      break;
-    case REG_BG3X_A|1:
-      ppu_io_a.bgx[1].WriteByte(1, value);
-      break;
-    case REG_BG3X_A|2:
-      ppu_io_a.bgx[1].WriteByte(2, value);
-      break;
-    case REG_BG3X_A|3:
-      ppu_io_a.bgx[1].WriteByte(3, value);
-      break;
-    case REG_BG3Y_A|0:
-      ppu_io_a.bgy[1].WriteByte(0, value);
-      break;
-    case REG_BG3Y_A|1:
-      ppu_io_a.bgy[1].WriteByte(1, value);
-      break;
-    case REG_BG3Y_A|2:
-      ppu_io_a.bgy[1].WriteByte(2, value);
-      break;
-    case REG_BG3Y_A|3:
-      ppu_io_a.bgy[1].WriteByte(3, value);
-      break;
-    case REG_WIN0H_A|0:
-      ppu_io_a.winh[0].WriteByte(0, value);
-      break;
-    case REG_WIN0H_A|1:
-      ppu_io_a.winh[0].WriteByte(1, value);
-      break;
-    case REG_WIN1H_A|0:
-      ppu_io_a.winh[1].WriteByte(0, value);
-      break;
-    case REG_WIN1H_A|1:
-      ppu_io_a.winh[1].WriteByte(1, value);
-      break;
-    case REG_WIN0V_A|0:
-      ppu_io_a.winv[0].WriteByte(0, value);
-      break;
-    case REG_WIN0V_A|1:
-      ppu_io_a.winv[0].WriteByte(1, value);
-      break;
-    case REG_WIN1V_A|0:
-      ppu_io_a.winv[1].WriteByte(0, value);
-      break;
-    case REG_WIN1V_A|1:
-      ppu_io_a.winv[1].WriteByte(1, value);
-      break;
-    case REG_WININ_A|0:
-      ppu_io_a.winin.WriteByte(0, value);
-      break;
-    case REG_WININ_A|1:
-      ppu_io_a.winin.WriteByte(1, value);
-      break;
-    case REG_WINOUT_A|0:
-      ppu_io_a.winout.WriteByte(0, value);
-      break;
-    case REG_WINOUT_A|1:
-      ppu_io_a.winout.WriteByte(1, value);
-      break;
-    case REG_MOSAIC_A|0:
-      ppu_io_a.mosaic.WriteByte(0, value);
-      break;
-    case REG_MOSAIC_A|1:
-      ppu_io_a.mosaic.WriteByte(1, value);
-      break;
-    case REG_MOSAIC_A|2:
-    case REG_MOSAIC_A|3:
-      break;
-    case REG_BLDCNT_A|0:
-      ppu_io_a.bldcnt.WriteByte(0, value);
-      break;
-    case REG_BLDCNT_A|1:
-      ppu_io_a.bldcnt.WriteByte(1, value);
-      break;
-    case REG_BLDALPHA_A|0:
-      ppu_io_a.bldalpha.WriteByte(0, value);
-      break;
-    case REG_BLDALPHA_A|1:
-      ppu_io_a.bldalpha.WriteByte(1, value);
-      break;
-    case REG_BLDY_A|0:
-      ppu_io_a.bldy.WriteByte(0, value);
-      break;
-    case REG_BLDY_A|1:
-    case REG_BLDY_A|2:
-    case REG_BLDY_A|3:
-      break;
-      
-    // PPU engine B
-    case REG_DISPCNT_B|0:
-      ppu_io_b.dispcnt.WriteByte(0, value);
-      break;
-    case REG_DISPCNT_B|1:
-      ppu_io_b.dispcnt.WriteByte(1, value);
-      break;
-    case REG_DISPCNT_B|2:
-      ppu_io_b.dispcnt.WriteByte(2, value);
-      break;
-    case REG_DISPCNT_B|3:
-      ppu_io_b.dispcnt.WriteByte(3, value);
-      break;
-    case REG_BG0CNT_B|0:
-      ppu_io_b.bgcnt[0].WriteByte(0, value);
-      break;
-    case REG_BG0CNT_B|1:
-      ppu_io_b.bgcnt[0].WriteByte(1, value);
-      break;
-    case REG_BG1CNT_B|0:
-      ppu_io_b.bgcnt[1].WriteByte(0, value);
-      break;
-    case REG_BG1CNT_B|1:
-      ppu_io_b.bgcnt[1].WriteByte(1, value);
-      break;
-    case REG_BG2CNT_B|0:
-      ppu_io_b.bgcnt[2].WriteByte(0, value);
-      break;
-    case REG_BG2CNT_B|1:
-      ppu_io_b.bgcnt[2].WriteByte(1, value);
-      break;
-    case REG_BG3CNT_B|0:
-      ppu_io_b.bgcnt[3].WriteByte(0, value);
-      break;
-    case REG_BG3CNT_B|1:
-      ppu_io_b.bgcnt[3].WriteByte(1, value);
-      break;
-    case REG_BG0HOFS_B|0:
-      ppu_io_b.bghofs[0].WriteByte(0, value);
-      break;
-    case REG_BG0HOFS_B|1:
-      ppu_io_b.bghofs[0].WriteByte(1, value);
-      break;
-    case REG_BG0VOFS_B|0:
-      ppu_io_b.bgvofs[0].WriteByte(0, value);
-      break;
-    case REG_BG0VOFS_B|1:
-      ppu_io_b.bgvofs[0].WriteByte(1, value);
-      break;
-    case REG_BG1HOFS_B|0:
-      ppu_io_b.bghofs[1].WriteByte(0, value);
-      break;
-    case REG_BG1HOFS_B|1:
-      ppu_io_b.bghofs[1].WriteByte(1, value);
-      break;
-    case REG_BG1VOFS_B|0:
-      ppu_io_b.bgvofs[1].WriteByte(0, value);
-      break;
-    case REG_BG1VOFS_B|1:
-      ppu_io_b.bgvofs[1].WriteByte(1, value);
-      break;
-    case REG_BG2HOFS_B|0:
-      ppu_io_b.bghofs[2].WriteByte(0, value);
-      break;
-    case REG_BG2HOFS_B|1:
-      ppu_io_b.bghofs[2].WriteByte(1, value);
-      break;
-    case REG_BG2VOFS_B|0:
-      ppu_io_b.bgvofs[2].WriteByte(0, value);
-      break;
-    case REG_BG2VOFS_B|1:
-      ppu_io_b.bgvofs[2].WriteByte(1, value);
-      break;
-    case REG_BG3HOFS_B|0:
-      ppu_io_b.bghofs[3].WriteByte(0, value);
-      break;
-    case REG_BG3HOFS_B|1:
-      ppu_io_b.bghofs[3].WriteByte(1, value);
-      break;
-    case REG_BG3VOFS_B|0:
-      ppu_io_b.bgvofs[3].WriteByte(0, value);
-      break;
-    case REG_BG3VOFS_B|1:
-      ppu_io_b.bgvofs[3].WriteByte(1, value);
-      break;
-    case REG_BG2PA_B|0:
-      ppu_io_b.bgpa[0].WriteByte(0, value);
-      break;
-    case REG_BG2PA_B|1:
-      ppu_io_b.bgpa[0].WriteByte(1, value);
-      break;
-    case REG_BG2PB_B|0:
-      ppu_io_b.bgpb[0].WriteByte(0, value);
-      break;
-    case REG_BG2PB_B|1:
-      ppu_io_b.bgpb[0].WriteByte(1, value);
-      break;
-    case REG_BG2PC_B|0:
-      ppu_io_b.bgpc[0].WriteByte(0, value);
-      break;
-    case REG_BG2PC_B|1:
-      ppu_io_b.bgpc[0].WriteByte(1, value);
-      break;
-    case REG_BG2PD_B|0:
-      ppu_io_b.bgpd[0].WriteByte(0, value);
-      break;
-    case REG_BG2PD_B|1:
-      ppu_io_b.bgpd[0].WriteByte(1, value);
-      break;
-    case REG_BG2X_B|0:
-      ppu_io_b.bgx[0].WriteByte(0, value);
-      break;
-    case REG_BG2X_B|1:
-      ppu_io_b.bgx[0].WriteByte(1, value);
-      break;
-    case REG_BG2X_B|2:
-      ppu_io_b.bgx[0].WriteByte(2, value);
-      break;
-    case REG_BG2X_B|3:
-      ppu_io_b.bgx[0].WriteByte(3, value);
-      break;
-    case REG_BG2Y_B|0:
-      ppu_io_b.bgy[0].WriteByte(0, value);
-      break;
-    case REG_BG2Y_B|1:
-      ppu_io_b.bgy[0].WriteByte(1, value);
-      break;
-    case REG_BG2Y_B|2:
-      ppu_io_b.bgy[0].WriteByte(2, value);
-      break;
-    case REG_BG2Y_B|3:
-      ppu_io_b.bgy[0].WriteByte(3, value);
-      break;
-    case REG_BG3PA_B|0:
-      ppu_io_b.bgpa[1].WriteByte(0, value);
-      break;
-    case REG_BG3PA_B|1:
-      ppu_io_b.bgpa[1].WriteByte(1, value);
-      break;
-    case REG_BG3PB_B|0:
-      ppu_io_b.bgpb[1].WriteByte(0, value);
-      break;
-    case REG_BG3PB_B|1:
-      ppu_io_b.bgpb[1].WriteByte(1, value);
-      break;
-    case REG_BG3PC_B|0:
-      ppu_io_b.bgpc[1].WriteByte(0, value);
-      break;
-    case REG_BG3PC_B|1:
-      ppu_io_b.bgpc[1].WriteByte(1, value);
-      break;
-    case REG_BG3PD_B|0:
-      ppu_io_b.bgpd[1].WriteByte(0, value);
-      break;
-    case REG_BG3PD_B|1:
-      ppu_io_b.bgpd[1].WriteByte(1, value);
-      break;
-    case REG_BG3X_B|0:
-      ppu_io_b.bgx[1].WriteByte(0, value);
-      break;
-    case REG_BG3X_B|1:
-      ppu_io_b.bgx[1].WriteByte(1, value);
-      break;
-    case REG_BG3X_B|2:
-      ppu_io_b.bgx[1].WriteByte(2, value);
-      break;
-    case REG_BG3X_B|3:
-      ppu_io_b.bgx[1].WriteByte(3, value);
-      break;
-    case REG_BG3Y_B|0:
-      ppu_io_b.bgy[1].WriteByte(0, value);
-      break;
-    case REG_BG3Y_B|1:
-      ppu_io_b.bgy[1].WriteByte(1, value);
-      break;
-    case REG_BG3Y_B|2:
-      ppu_io_b.bgy[1].WriteByte(2, value);
-      break;
-    case REG_BG3Y_B|3:
-      ppu_io_b.bgy[1].WriteByte(3, value);
-      break;
-    case REG_WIN0H_B|0:
-      ppu_io_b.winh[0].WriteByte(0, value);
-      break;
-    case REG_WIN0H_B|1:
-      ppu_io_b.winh[0].WriteByte(1, value);
-      break;
-    case REG_WIN1H_B|0:
-      ppu_io_b.winh[1].WriteByte(0, value);
-      break;
-    case REG_WIN1H_B|1:
-      ppu_io_b.winh[1].WriteByte(1, value);
-      break;
-    case REG_WIN0V_B|0:
-      ppu_io_b.winv[0].WriteByte(0, value);
-      break;
-    case REG_WIN0V_B|1:
-      ppu_io_b.winv[0].WriteByte(1, value);
-      break;
-    case REG_WIN1V_B|0:
-      ppu_io_b.winv[1].WriteByte(0, value);
-      break;
-    case REG_WIN1V_B|1:
-      ppu_io_b.winv[1].WriteByte(1, value);
-      break;
-    case REG_WININ_B|0:
-      ppu_io_b.winin.WriteByte(0, value);
-      break;
-    case REG_WININ_B|1:
-      ppu_io_b.winin.WriteByte(1, value);
-      break;
-    case REG_WINOUT_B|0:
-      ppu_io_b.winout.WriteByte(0, value);
-      break;
-    case REG_WINOUT_B|1:
-      ppu_io_b.winout.WriteByte(1, value);
-      break;
-    case REG_MOSAIC_B|0:
-      ppu_io_b.mosaic.WriteByte(0, value);
-      break;
-    case REG_MOSAIC_B|1:
-      ppu_io_b.mosaic.WriteByte(1, value);
-      break;
-    case REG_MOSAIC_B|2:
-    case REG_MOSAIC_B|3:
-      break;
-    case REG_BLDCNT_B|0:
-      ppu_io_b.bldcnt.WriteByte(0, value);
-      break;
-    case REG_BLDCNT_B|1:
-      ppu_io_b.bldcnt.WriteByte(1, value);
-      break;
-    case REG_BLDALPHA_B|0:
-      ppu_io_b.bldalpha.WriteByte(0, value);
-      break;
-    case REG_BLDALPHA_B|1:
-      ppu_io_b.bldalpha.WriteByte(1, value);
-      break;
-    case REG_BLDY_B|0:
-      ppu_io_b.bldy.WriteByte(0, value);
-      break;
-    case REG_BLDY_B|1:
-    case REG_BLDY_B|2:
-    case REG_BLDY_B|3:
-      break;
+  // IPC
+  mmio.MapReadBytes<u16>(REG_IPCSYNC, [this](uint offset) {
+    return ipc.ipcsync.ReadByte(IPC::Client::ARM9, offset);
+  });
+  mmio.MapWriteBytes<u16>(REG_IPCSYNC, [this](uint offset, u8 value) {
+    ipc.ipcsync.WriteByte(IPC::Client::ARM9, offset, value);
+  });
+  mmio.MapReadBytes<u16>(REG_IPCFIFOCNT, [this](uint offset) {
+    return ipc.ipcfifocnt.ReadByte(IPC::Client::ARM9, offset);
+  });
+  mmio.MapWriteBytes<u16>(REG_IPCFIFOCNT, [this](uint offset, u8 value) {
+    ipc.ipcfifocnt.WriteByte(IPC::Client::ARM9, offset, value);
+  });
+  mmio.MapWriteRange<u8>(REG_IPCFIFOSEND, REG_IPCFIFOSEND|3, [this](u32, u8 value) {
+    ipc.ipcfifosend.WriteByte(IPC::Client::ARM9, value);
+  });
+  mmio.MapWriteRange<u16>(REG_IPCFIFOSEND, REG_IPCFIFOSEND|2, [this](u32, u16 value) {
+    ipc.ipcfifosend.WriteHalf(IPC::Client::ARM9, value);
+  });
+  mmio.MapWrite<u32>(REG_IPCFIFOSEND, [this](u32, u32 value) {
+    ipc.ipcfifosend.WriteWord(IPC::Client::ARM9, value);
+  });
+  mmio.MapReadRange<u8>(REG_IPCFIFORECV, REG_IPCFIFORECV|3, [this](u32 address) {
+    return ipc.ipcfiforecv.ReadByte(IPC::Client::ARM9, address & 3);
+  });
+  mmio.MapReadRange<u16>(REG_IPCFIFORECV, REG_IPCFIFORECV|2, [this](u32 address) {
+    return ipc.ipcfiforecv.ReadHalf(IPC::Client::ARM9, address & 2);
+  });
+  mmio.MapRead<u32>(REG_IPCFIFORECV, [this](u32) {
+    return ipc.ipcfiforecv.ReadWord(IPC::Client::ARM9);
+  });
 
-    // DMA
-    case REG_DMA0SAD|0:
-      dma.Write(0, 0, value);
-      break;
-    case REG_DMA0SAD|1:
-      dma.Write(0, 1, value);
-      break;
-    case REG_DMA0SAD|2:
-      dma.Write(0, 2, value);
-      break;
-    case REG_DMA0SAD|3:
-      dma.Write(0, 3, value);
-      break;
-    case REG_DMA0DAD|0:
-      dma.Write(0, 4, value);
-      break;
-    case REG_DMA0DAD|1:
-      dma.Write(0, 5, value);
-      break;
-    case REG_DMA0DAD|2:
-      dma.Write(0, 6, value);
-      break;
-    case REG_DMA0DAD|3:
-      dma.Write(0, 7, value);
-      break;
-    case REG_DMA0CNT_L|0:
-      dma.Write(0, 8, value);
-      break;
-    case REG_DMA0CNT_L|1:
-      dma.Write(0, 9, value);
-      break;
-    case REG_DMA0CNT_H|0:
-      dma.Write(0, 10, value);
-      break;
-    case REG_DMA0CNT_H|1:
-      dma.Write(0, 11, value);
-      break;
-    case REG_DMA1SAD|0:
-      dma.Write(1, 0, value);
-      break;
-    case REG_DMA1SAD|1:
-      dma.Write(1, 1, value);
-      break;
-    case REG_DMA1SAD|2:
-      dma.Write(1, 2, value);
-      break;
-    case REG_DMA1SAD|3:
-      dma.Write(1, 3, value);
-      break;
-    case REG_DMA1DAD|0:
-      dma.Write(1, 4, value);
-      break;
-    case REG_DMA1DAD|1:
-      dma.Write(1, 5, value);
-      break;
-    case REG_DMA1DAD|2:
-      dma.Write(1, 6, value);
-      break;
-    case REG_DMA1DAD|3:
-      dma.Write(1, 7, value);
-      break;
-    case REG_DMA1CNT_L|0:
-      dma.Write(1, 8, value);
-      break;
-    case REG_DMA1CNT_L|1:
-      dma.Write(1, 9, value);
-      break;
-    case REG_DMA1CNT_H|0:
-      dma.Write(1, 10, value);
-      break;
-    case REG_DMA1CNT_H|1:
-      dma.Write(1, 11, value);
-      break;
-    case REG_DMA2SAD|0:
-      dma.Write(2, 0, value);
-      break;
-    case REG_DMA2SAD|1:
-      dma.Write(2, 1, value);
-      break;
-    case REG_DMA2SAD|2:
-      dma.Write(2, 2, value);
-      break;
-    case REG_DMA2SAD|3:
-      dma.Write(2, 3, value);
-      break;
-    case REG_DMA2DAD|0:
-      dma.Write(2, 4, value);
-      break;
-    case REG_DMA2DAD|1:
-      dma.Write(2, 5, value);
-      break;
-    case REG_DMA2DAD|2:
-      dma.Write(2, 6, value);
-      break;
-    case REG_DMA2DAD|3:
-      dma.Write(2, 7, value);
-      break;
-    case REG_DMA2CNT_L|0:
-      dma.Write(2, 8, value);
-      break;
-    case REG_DMA2CNT_L|1:
-      dma.Write(2, 9, value);
-      break;
-    case REG_DMA2CNT_H|0:
-      dma.Write(2, 10, value);
-      break;
-    case REG_DMA2CNT_H|1:
-      dma.Write(2, 11, value);
-      break;
-    case REG_DMA3SAD|0:
-      dma.Write(3, 0, value);
-      break;
-    case REG_DMA3SAD|1:
-      dma.Write(3, 1, value);
-      break;
-    case REG_DMA3SAD|2:
-      dma.Write(3, 2, value);
-      break;
-    case REG_DMA3SAD|3:
-      dma.Write(3, 3, value);
-      break;
-    case REG_DMA3DAD|0:
-      dma.Write(3, 4, value);
-      break;
-    case REG_DMA3DAD|1:
-      dma.Write(3, 5, value);
-      break;
-    case REG_DMA3DAD|2:
-      dma.Write(3, 6, value);
-      break;
-    case REG_DMA3DAD|3:
-      dma.Write(3, 7, value);
-      break;
-    case REG_DMA3CNT_L|0:
-      dma.Write(3, 8, value);
-      break;
-    case REG_DMA3CNT_L|1:
-      dma.Write(3, 9, value);
-      break;
-    case REG_DMA3CNT_H|0:
-      dma.Write(3, 10, value);
-      break;
-    case REG_DMA3CNT_H|1:
-      dma.Write(3, 11, value);
-      break;
-    case REG_DMA0FILL|0:
-      dma.WriteFill(0, value);
-      break;
-    case REG_DMA0FILL|1:
-      dma.WriteFill(1, value);
-      break;
-    case REG_DMA0FILL|2:
-      dma.WriteFill(2, value);
-      break;
-    case REG_DMA0FILL|3:
-      dma.WriteFill(3, value);
-      break;
-    case REG_DMA1FILL|0:
-      dma.WriteFill(4, value);
-      break;
-    case REG_DMA1FILL|1:
-      dma.WriteFill(5, value);
-      break;
-    case REG_DMA1FILL|2:
-      dma.WriteFill(6, value);
-      break;
-    case REG_DMA1FILL|3:
-      dma.WriteFill(7, value);
-      break;
-    case REG_DMA2FILL|0:
-      dma.WriteFill(8, value);
-      break;
-    case REG_DMA2FILL|1:
-      dma.WriteFill(9, value);
-      break;
-    case REG_DMA2FILL|2:
-      dma.WriteFill(10, value);
-      break;
-    case REG_DMA2FILL|3:
-      dma.WriteFill(11, value);
-      break;
-    case REG_DMA3FILL|0:
-      dma.WriteFill(12, value);
-      break;
-    case REG_DMA3FILL|1:
-      dma.WriteFill(13, value);
-      break;
-    case REG_DMA3FILL|2:
-      dma.WriteFill(14, value);
-      break;
-    case REG_DMA3FILL|3:
-      dma.WriteFill(15, value);
-      break;
+  // Cartridge interface
+  mmio.MapRegister<u16>(REG_AUXSPICNT, cart.auxspicnt);
+  mmio.MapRead<u8>(REG_AUXSPIDATA|0, [this](u32) { return cart.ReadSPI(); });
+  mmio.MapRead<u8>(REG_AUXSPIDATA|1, [](u32) { return 0; });
+  mmio.MapRegister<u32>(REG_ROMCTRL, cart.romctrl);
+  mmio.MapReadBytes<u32>(REG_CARDCMD|0, [this](uint offset) { return cart.cardcmd.ReadByte(offset | 0); });
+  mmio.MapReadBytes<u32>(REG_CARDCMD|4, [this](uint offset) { return cart.cardcmd.ReadByte(offset | 4); });
+  mmio.MapWriteBytes<u32>(REG_CARDCMD|0, [this](uint offset, u8 value) { cart.cardcmd.WriteByte(offset | 0, value); });
+  mmio.MapWriteBytes<u32>(REG_CARDCMD|4, [this](uint offset, u8 value) { cart.cardcmd.WriteByte(offset | 4, value); });
+  mmio.MapReadRange<u8>(REG_CARDDATA, REG_CARDDATA|3, [](u32) {
+    ASSERT(false, "ARM9: unhandled byte read from REG_CARDDATA");
+    return 0;
+  });
+  mmio.MapRead<u32>(REG_CARDDATA, [this](u32) { return cart.ReadROM(); });
 
-    // Timers
-    case REG_TM0CNT_L|0:
-      timer.Write(0, 0, value);
-      break;
-    case REG_TM0CNT_L|1:
-      timer.Write(0, 1, value);
-      break;
-    case REG_TM0CNT_H|0:
-      timer.Write(0, 2, value);
-      break;
-    case REG_TM0CNT_H|1:
-      timer.Write(0, 3, value);
-      break;
-    case REG_TM1CNT_L|0:
-      timer.Write(1, 0, value);
-      break;
-    case REG_TM1CNT_L|1:
-      timer.Write(1, 1, value);
-      break;
-    case REG_TM1CNT_H|0:
-      timer.Write(1, 2, value);
-      break;
-    case REG_TM1CNT_H|1:
-      timer.Write(1, 3, value);
-      break;
-    case REG_TM2CNT_L|0:
-      timer.Write(2, 0, value);
-      break;
-    case REG_TM2CNT_L|1:
-      timer.Write(2, 1, value);
-      break;
-    case REG_TM2CNT_H|0:
-      timer.Write(2, 2, value);
-      break;
-    case REG_TM2CNT_H|1:
-      timer.Write(2, 3, value);
-      break;
-    case REG_TM3CNT_L|0:
-      timer.Write(3, 0, value);
-      break;
-    case REG_TM3CNT_L|1:
-      timer.Write(3, 1, value);
-      break;
-    case REG_TM3CNT_H|0:
-      timer.Write(3, 2, value);
-      break;
-    case REG_TM3CNT_H|1:
-      timer.Write(3, 3, value);
-      break;
+  // IRQ
+  mmio.MapRegister<u32>(REG_IME, irq9.ime);
+  mmio.MapRegister<u32>(REG_IE, irq9.ie);
+  mmio.MapRegister<u32>(REG_IF, irq9._if);
 
-    // IPC
-    case REG_IPCSYNC|0:
-      ipc.ipcsync.WriteByte(IPC::Client::ARM9, 0, value);
-      break;
-    case REG_IPCSYNC|1:
-      ipc.ipcsync.WriteByte(IPC::Client::ARM9, 1, value);
-      break;
-    case REG_IPCFIFOCNT|0:
-      ipc.ipcfifocnt.WriteByte(IPC::Client::ARM9, 0, value);
-      break;
-    case REG_IPCFIFOCNT|1:
-      ipc.ipcfifocnt.WriteByte(IPC::Client::ARM9, 1, value);
-      break;
-    case REG_IPCFIFOSEND|0:
-    case REG_IPCFIFOSEND|1:
-    case REG_IPCFIFOSEND|2:
-    case REG_IPCFIFOSEND|3:
-      ipc.ipcfifosend.WriteByte(IPC::Client::ARM9, value);
-      break;
+  // Memory control
+  mmio.MapWrite<u8>(REG_VRAMCNT_A, [this](u32, u8 value) { vram.vramcnt_a.WriteByte(value); });
+  mmio.MapWrite<u8>(REG_VRAMCNT_B, [this](u32, u8 value) { vram.vramcnt_b.WriteByte(value); });
+  // Banks C and D and the shared WRAM can be mapped to the ARM7, see CPUSync::Defer().
+  mmio.MapWrite<u8>(REG_VRAMCNT_C, [this](u32, u8 value) {
+    cpu_sync.Defer([this, value]() { vram.vramcnt_c.WriteByte(value); });
+  });
+  mmio.MapWrite<u8>(REG_VRAMCNT_D, [this](u32, u8 value) {
+    cpu_sync.Defer([this, value]() { vram.vramcnt_d.WriteByte(value); });
+  });
+  mmio.MapWrite<u8>(REG_VRAMCNT_E, [this](u32, u8 value) { vram.vramcnt_e.WriteByte(value); });
+  mmio.MapWrite<u8>(REG_VRAMCNT_F, [this](u32, u8 value) { vram.vramcnt_f.WriteByte(value); });
+  mmio.MapWrite<u8>(REG_VRAMCNT_G, [this](u32, u8 value) { vram.vramcnt_g.WriteByte(value); });
+  mmio.MapWrite<u8>(REG_VRAMCNT_H, [this](u32, u8 value) { vram.vramcnt_h.WriteByte(value); });
+  mmio.MapWrite<u8>(REG_VRAMCNT_I, [this](u32, u8 value) { vram.vramcnt_i.WriteByte(value); });
+  mmio.MapRead<u8>(REG_WRAMCNT, [this](u32) { return wramcnt.ReadByte(); });
+  mmio.MapWrite<u8>(REG_WRAMCNT, [this](u32, u8 value) {
+    cpu_sync.Defer([this, value]() { wramcnt.WriteByte(value); });
+  });
 
-    // Cartridge interface
-    case REG_AUXSPICNT|0:
-      cart.auxspicnt.WriteByte(0, value);
-      break;
-    case REG_AUXSPICNT|1:
-      cart.auxspicnt.WriteByte(1, value);
-      break;
-    case REG_ROMCTRL|0:
-      cart.romctrl.WriteByte(0, value);
-      break;
-    case REG_ROMCTRL|1:
-      cart.romctrl.WriteByte(1, value);
-      break;
-    case REG_ROMCTRL|2:
-      cart.romctrl.WriteByte(2, value);
-      break;
-    case REG_ROMCTRL|3:
-      cart.romctrl.WriteByte(3, value);
-      break;
-    case REG_CARDCMD|0:
-      cart.cardcmd.WriteByte(0, value);
-      break;
-    case REG_CARDCMD|1:
-      cart.cardcmd.WriteByte(1, value);
-      break;
-    case REG_CARDCMD|2:
-      cart.cardcmd.WriteByte(2, value);
-      break;
-    case REG_CARDCMD|3:
-      cart.cardcmd.WriteByte(3, value);
-      break;
-    case REG_CARDCMD|4:
-      cart.cardcmd.WriteByte(4, value);
-      break;
-    case REG_CARDCMD|5:
-      cart.cardcmd.WriteByte(5, value);
-      break;
-    case REG_CARDCMD|6:
-      cart.cardcmd.WriteByte(6, value);
-      break;
-    case REG_CARDCMD|7:
-      cart.cardcmd.WriteByte(7, value);
-      break;
+  // Math engine
+  SetupMathEngineMMIO();
 
-    // IRQ
-    case REG_IME|0:
-      irq9.ime.WriteByte(0, value);
-      break;
-    case REG_IME|1:
-      irq9.ime.WriteByte(1, value);
-      break;
-    case REG_IME|2:
-      irq9.ime.WriteByte(2, value);
-      break;
-    case REG_IME|3:
-      irq9.ime.WriteByte(3, value);
-      break;
-    case REG_IE|0:
-      irq9.ie.WriteByte(0, value);
-      break;
-    case REG_IE|1:
-      irq9.ie.WriteByte(1, value);
-      break;
-    case REG_IE|2:
-      irq9.ie.WriteByte(2, value);
-      break;
-    case REG_IE|3:
-      irq9.ie.WriteByte(3, value);
-      break;
-    case REG_IF|0:
-      irq9._if.WriteByte(0, value);
-      break;
-    case REG_IF|1:
-      irq9._if.WriteByte(1, value);
-      break;
-    case REG_IF|2:
-      irq9._if.WriteByte(2, value);
-      break;
-    case REG_IF|3:
-      irq9._if.WriteByte(3, value);
-      break;
+  mmio.MapRead<u8>(REG_POSTFLG, [](u32) { return 1; });
 
-    // Memory control
-    case REG_VRAMCNT_A:
-      vram.vramcnt_a.WriteByte(value);
-      break;
-    case REG_VRAMCNT_B:
-      vram.vramcnt_b.WriteByte(value);
-      break;
-    case REG_VRAMCNT_C:
-      vram.vramcnt_c.WriteByte(value);
-      break;
-    case REG_VRAMCNT_D:
-      vram.vramcnt_d.WriteByte(value);
-      break;
-    case REG_VRAMCNT_E:
-      vram.vramcnt_e.WriteByte(value);
-      break;
-    case REG_VRAMCNT_F:
-      vram.vramcnt_f.WriteByte(value);
-      break;
-    case REG_VRAMCNT_G:
-      vram.vramcnt_g.WriteByte(value);
-      break;
-    case REG_WRAMCNT:
-      wramcnt.WriteByte(value);
-      break;
-    case REG_VRAMCNT_H:
-      vram.vramcnt_h.WriteByte(value);
-      break;
-    case REG_VRAMCNT_I:
-      vram.vramcnt_i.WriteByte(value);
-      break;
+  // GPU
+  mmio.MapRegister<u16>(REG_DISP3DCNT, gpu_io.disp3dcnt);
+  mmio.MapRegister<u16>(REG_POWCNT1, video_unit.powcnt1);
+  mmio.MapRegister<u32>(REG_GXSTAT, gpu_io.gxstat);
+  mmio.MapWriteRange<u32>(REG_GXFIFO_LO, REG_GXFIFO_HI, [&gpu_io](u32, u32 value) {
+    gpu_io.WriteGXFIFO(value);
+  });
+  mmio.MapWriteRange<u32>(REG_GXCMDPORT_LO, REG_GXCMDPORT_HI, [&gpu_io](u32 address, u32 value) {
+    gpu_io.WriteCommandPort(address & 0x1FF, value);
+  });
+  mmio.MapReadRange<u8>(REG_CLIPMTX_RESULT_LO, REG_CLIPMTX_RESULT_HI, [&gpu_io](u32 address) {
+    return gpu_io.ReadClipMatrix<u8>(address - REG_CLIPMTX_RESULT_LO);
+  });
+  mmio.MapReadRange<u16>(REG_CLIPMTX_RESULT_LO, REG_CLIPMTX_RESULT_HI, [&gpu_io](u32 address) {
+    return gpu_io.ReadClipMatrix<u16>(address - REG_CLIPMTX_RESULT_LO);
+  });
+  mmio.MapReadRange<u32>(REG_CLIPMTX_RESULT_LO, REG_CLIPMTX_RESULT_HI, [&gpu_io](u32 address) {
+    return gpu_io.ReadClipMatrix<u32>(address - REG_CLIPMTX_RESULT_LO);
+  });
+}
 
-    // Math engine
-    case REG_DIVCNT|0:
-      math_engine.divcnt.WriteByte(0, value);
-      break;
-    case REG_DIVCNT|1:
-      math_engine.divcnt.WriteByte(1, value);
-      break;
-    case REG_DIV_NUMER|0:
-      math_engine.div_numer.WriteByte(0, value);
-      break;
-    case REG_DIV_NUMER|1:
-      math_engine.div_numer.WriteByte(1, value);
-      break;
-    case REG_DIV_NUMER|2:
-      math_engine.div_numer.WriteByte(2, value);
-      break;
-    case REG_DIV_NUMER|3:
-      math_engine.div_numer.WriteByte(3, value);
-      break;
-    case REG_DIV_NUMER|4:
-      math_engine.div_numer.WriteByte(4, value);
-      break;
-    case REG_DIV_NUMER|5:
-      math_engine.div_numer.WriteByte(5, value);
-      break;
-    case REG_DIV_NUMER|6:
-      math_engine.div_numer.WriteByte(6, value);
-      break;
-    case REG_DIV_NUMER|7:
-      math_engine.div_numer.WriteByte(7, value);
-      break;
-    case REG_DIV_DENOM|0:
-      math_engine.div_denom.WriteByte(0, value);
-      break;
-    case REG_DIV_DENOM|1:
-      math_engine.div_denom.WriteByte(1, value);
-      break;
-    case REG_DIV_DENOM|2:
-      math_engine.div_denom.WriteByte(2, value);
-      break;
-    case REG_DIV_DENOM|3:
-      math_engine.div_denom.WriteByte(3, value);
-      break;
-    case REG_DIV_DENOM|4:
-      math_engine.div_denom.WriteByte(4, value);
-      break;
-    case REG_DIV_DENOM|5:
-      math_engine.div_denom.WriteByte(5, value);
-      break;
-    case REG_DIV_DENOM|6:
-      math_engine.div_denom.WriteByte(6, value);
-      break;
-    case REG_DIV_DENOM|7:
-      math_engine.div_denom.WriteByte(7, value);
-      break;
-    case REG_SQRTCNT|0:
-      math_engine.sqrtcnt.WriteByte(0, value);
-      break;
-    case REG_SQRTCNT|1:
-      math_engine.sqrtcnt.WriteByte(1, value);
-      break;
-    case REG_SQRT_PARAM|0:
-      math_engine.sqrt_param.WriteByte(0, value);
-      break;
-    case REG_SQRT_PARAM|1:
-      math_engine.sqrt_param.WriteByte(1, value);
-      break;
-    case REG_SQRT_PARAM|2:
-      math_engine.sqrt_param.WriteByte(2, value);
-      break;
-    case REG_SQRT_PARAM|3:
-      math_engine.sqrt_param.WriteByte(3, value);
-      break;
-    case REG_SQRT_PARAM|4:
-      math_engine.sqrt_param.WriteByte(4, value);
-      break;
-    case REG_SQRT_PARAM|5:
-      math_engine.sqrt_param.WriteByte(5, value);
-      break;
-    case REG_SQRT_PARAM|6:
-      math_engine.sqrt_param.WriteByte(6, value);
-      break;
-    case REG_SQRT_PARAM|7:
-      math_engine.sqrt_param.WriteByte(7, value);
-      break;
+void ARM9MemoryBus::SetupPPUMMIO(u32 base, PPU::MMIO& ppu_io) {
+  auto Reg = [base](u32 address_a) { return address_a - REG_DISPCNT_A + base; };
 
-    // GPU
-    case REG_DISP3DCNT|0:
-      gpu_io.disp3dcnt.WriteByte(0, value);
-      break;
-    case REG_DISP3DCNT|1:
-      gpu_io.disp3dcnt.WriteByte(1, value);
-      break;
-    case REG_POWCNT1|0:
-      video_unit.powcnt1.WriteByte(0, value);
-      break;
-    case REG_POWCNT1|1:
-      video_unit.powcnt1.WriteByte(1, value);
-      break;
-    case REG_GXSTAT|0:
-      gpu_io.gxstat.WriteByte(0, value);
-      break;
-    case REG_GXSTAT|1:
-      gpu_io.gxstat.WriteByte(1, value);
-      break;
-    case REG_GXSTAT|2:
-      gpu_io.gxstat.WriteByte(2, value);
-      break;
-    case REG_GXSTAT|3:
-      gpu_io.gxstat.WriteByte(3, value);
-      break;
+  mmio.MapRegister<u32>(Reg(REG_DISPCNT_A), ppu_io.dispcnt);
 
-    default:
-      LOG_WARN("ARM9: MMIO: unhandled write to 0x{0:08X} = 0x{1:02X}", address, value);
+  for (uint i = 0; i < 4; i++) {
+    mmio.MapRegister<u16>(Reg(REG_BG0CNT_A) + i * 2, ppu_io.bgcnt[i]);
+    mmio.MapWriteRegister<u16>(Reg(REG_BG0HOFS_A) + i * 4, ppu_io.bghofs[i]);
+    mmio.MapWriteRegister<u16>(Reg(REG_BG0VOFS_A) + i * 4, ppu_io.bgvofs[i]);
   }
-}
 
-void ARM9MemoryBus::WriteHalfIO(u32 address, u16 value) {
-  switch (address) {
-    case REG_IPCFIFOSEND|0:
-    case REG_IPCFIFOSEND|2:
-      ipc.ipcfifosend.WriteHalf(IPC::Client::ARM9, value);
-      break;
-    default:
-      WriteByteIO(address | 0, value & 0xFF);
-      WriteByteIO(address | 1, value >> 8);
-      break;
+  for (uint i = 0; i < 2; i++) {
+    auto offset = i * 0x10;
+    mmio.MapWriteRegister<u16>(Reg(REG_BG2PA_A) + offset, ppu_io.bgpa[i]);
+    mmio.MapWriteRegister<u16>(Reg(REG_BG2PB_A) + offset, ppu_io.bgpb[i]);
+    mmio.MapWriteRegister<u16>(Reg(REG_BG2PC_A) + offset, ppu_io.bgpc[i]);
+    mmio.MapWriteRegister<u16>(Reg(REG_BG2PD_A) + offset, ppu_io.bgpd[i]);
+    mmio.MapWriteRegister<u32>(Reg(REG_BG2X_A) + offset, ppu_io.bgx[i]);
+    mmio.MapWriteRegister<u32>(Reg(REG_BG2Y_A) + offset, ppu_io.bgy[i]);
+    mmio.MapWriteRegister<u16>(Reg(REG_WIN0H_A) + i * 2, ppu_io.winh[i]);
+    mmio.MapWriteRegister<u16>(Reg(REG_WIN0V_A) + i * 2, ppu_io.winv[i]);
   }
+
+  mmio.MapRegister<u16>(Reg(REG_WININ_A), ppu_io.winin);
+  mmio.MapRegister<u16>(Reg(REG_WINOUT_A), ppu_io.winout);
+  mmio.MapWriteBytes<u32>(Reg(REG_MOSAIC_A), [&ppu_io](uint offset, u8 value) {
+    if (offset < 2) ppu_io.mosaic.WriteByte(offset, value);
+  });
+  mmio.MapRegister<u16>(Reg(REG_BLDCNT_A), ppu_io.bldcnt);
+  mmio.MapRegister<u16>(Reg(REG_BLDALPHA_A), ppu_io.bldalpha);
+  mmio.MapWriteBytes<u32>(Reg(REG_BLDY_A), [&ppu_io](uint offset, u8 value) {
+    if (offset == 0) ppu_io.bldy.WriteByte(0, value);
+  });
 }
 
-void ARM9MemoryBus::WriteWordIO(u32 address, u32 value) {
-  switch (address) {
-    // IPC
-    case REG_IPCFIFOSEND:
-      ipc.ipcfifosend.WriteWord(IPC::Client::ARM9, value);
-      break;
-      
-    // GPU
-    case REG_GXFIFO_LO ... REG_GXFIFO_HI:
-      video_unit.gpu.WriteGXFIFO(value);
-      break;
-    case REG_GXCMDPORT_LO ... REG_GXCMDPORT_HI:
-      video_unit.gpu.WriteCommandPort(address & 0x1FF, value);
-      break;
-    default:
-      WriteByteIO(address | 0, u8(value >>  0));
-      WriteByteIO(address | 1, u8(value >>  8));
-      WriteByteIO(address | 2, u8(value >> 16));
-      WriteByteIO(address | 3, u8(value >> 24));
-      break;
-  }
+void ARM9MemoryBus::SetupMathEngineMMIO() {
+  // The 64-bit registers are mapped as two 32-bit halves.
+  auto MapRead64 = [this](u32 address, auto& reg) {
+    mmio.MapReadBytes<u32>(address|0, [&reg](uint offset) { return reg.ReadByte(offset | 0); });
+    mmio.MapReadBytes<u32>(address|4, [&reg](uint offset) { return reg.ReadByte(offset | 4); });
+  };
+
+  auto MapWrite64 = [this](u32 address, auto& reg) {
+    mmio.MapWriteBytes<u32>(address|0, [&reg](uint offset, u8 value) { reg.WriteByte(offset | 0, value); });
+    mmio.MapWriteBytes<u32>(address|4, [&reg](uint offset, u8 value) { reg.WriteByte(offset | 4, value); });
+  };
+
+  mmio.MapRegister<u16>(REG_DIVCNT, math_engine.divcnt);
+  MapRead64(REG_DIV_NUMER, math_engine.div_numer);
+  MapWrite64(REG_DIV_NUMER, math_engine.div_numer);
+  MapRead64(REG_DIV_DENOM, math_engine.div_denom);
+  MapWrite64(REG_DIV_DENOM, math_engine.div_denom);
+  MapRead64(REG_DIV_RESULT, math_engine.div_result);
+  MapRead64(REG_DIVREM_RESULT, math_engine.div_remain);
+  mmio.MapRegister<u16>(REG_SQRTCNT, math_engine.sqrtcnt);
+  mmio.MapReadRegister<u32>(REG_SQRT_RESULT, math_engine.sqrt_result);
+  MapRead64(REG_SQRT_PARAM, math_engine.sqrt_param);
+  MapWrite64(REG_SQRT_PARAM, math_engine.sqrt_param);
 }
 
 } // namespace Duality::Core
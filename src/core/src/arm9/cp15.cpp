@@ -41,6 +41,24 @@ void CP15::Reset() {
   Write(0, 9, 1, 1, 0x00000020);
 }
 
+void CP15::LoadState(StateReader& state) {
+  // Replay the register writes, so that the TCM configuration gets applied to the bus.
+  // The exception base is restored separately with the rest of the CPU state.
+  auto exception_base = core->ExceptionBase();
+  auto control = state.Read<u32>();
+  state.Check((control & 0x8080) == 0, "CP15: bad control register in save state.");
+  WriteControlRegister(1, 0, 0, control);
+  WriteDTCMConfig(9, 1, 0, state.Read<u32>());
+  WriteITCMConfig(9, 1, 1, state.Read<u32>());
+  core->ExceptionBase(exception_base);
+}
+
+void CP15::SaveState(StateWriter& state) {
+  state.Write(reg_control);
+  state.Write(reg_dtcm);
+  state.Write(reg_itcm);
+}
+
 void CP15::RegisterHandler(int cn, int cm, int opcode, ReadHandler handler) {
   handler_rd[Index(cn, cm, opcode)] = handler;
 }
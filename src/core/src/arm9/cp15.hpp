@@ -22,6 +22,8 @@ struct CP15 : arm::Coprocessor {
   CP15(arm::ARM* core, ARM9MemoryBus* bus);
 
   void Reset() override;
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
 
   auto Read (int opcode1, int cn, int cm, int opcode2) -> u32 override;
   void Write(int opcode1, int cn, int cm, int opcode2, u32 value) override;
@@ -2,14 +2,24 @@
  * Copyright (C) 2021 fleroviux
  */
 
+#include <algorithm>
+#include <chrono>
 #include <core/core.hpp>
-#include <fstream>
+#include <memory>
 #include <stdexcept>
+#include <string.h>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <util/log.hpp>
 
 #include "arm/arm.hpp"
 #include "arm7/arm7.hpp"
 #include "arm9/arm9.hpp"
+#include "cpu_thread.hpp"
 #include "interconnect.hpp"
+#include "profiler.hpp"
+#include "tracer.hpp"
 
 namespace Duality::Core {
 
@@ -36,11 +46,46 @@ struct Header {
   } arm9, arm7;
 } __attribute__((packed));
 
+/// Save state header
+struct StateHeader {
+  static constexpr u32 kMagic = 0x54535344; // "DSST"
+
+  /// Must be incremented whenever the layout of any component state changes.
+  static constexpr u32 kVersion = 9;
+
+  /// Only contains the guest RAM pages modified since the previous incremental state.
+  static constexpr u32 kFlagIncremental = 1;
+
+  u32 magic;
+  u32 version;
+  u32 size;
+  u32 flags;
+  u8 game_code[4];
+};
+
 struct CoreImpl {
   CoreImpl(std::string const& rom_path)
       : arm7(interconnect)
       , arm9(interconnect) {
     Load(rom_path);
+
+    if constexpr (gRunCPUsInParallel) {
+      if (std::thread::hardware_concurrency() >= 2) {
+        arm7_thread = std::make_unique<CPUThread>([this](uint cycles) {
+          Tracer::Bind bind_tracer{tracer};
+          Profiler::Bind bind_profiler{profiler, Profiler::Thread::ARM7};
+          arm7_executed = arm7.Run(cycles);
+        });
+      } else {
+        LOG_WARN("Core: the host has a single core, running the CPUs one after another.");
+      }
+    }
+  }
+
+ ~CoreImpl() {
+    if constexpr (gEnableTracing) {
+      StopTrace();
+    }
   }
 
   void SetAudioDevice(AudioDevice& device) {
@@ -59,95 +104,261 @@ struct CoreImpl {
     // TODO
   }
 
+  void SyncStorage() {
+    interconnect.spi.firmware.Sync();
+    interconnect.cart.FlushBackup();
+  }
+
+  void StartTrace(std::string const& path) {
+    if constexpr (gEnableTracing) {
+      tracer.Start(path);
+    } else {
+      LOG_WARN("Core: tracing is disabled in this build, see gEnableTracing.");
+    }
+  }
+
+  void StopTrace() {
+    if constexpr (gEnableTracing) {
+      tracer.Stop();
+    }
+  }
+
+  void SaveState(std::vector<u8>& buffer, bool incremental) {
+    // Keep the allocation around, so that saving repeatedly does not reallocate.
+    auto capacity = buffer.capacity();
+    buffer.clear();
+    buffer.reserve(capacity);
+
+    StateWriter state{buffer};
+    StateHeader state_header{};
+    state_header.magic = StateHeader::kMagic;
+    state_header.version = StateHeader::kVersion;
+    state_header.flags = incremental ? StateHeader::kFlagIncremental : 0;
+    memcpy(state_header.game_code, header.game_code, sizeof(header.game_code));
+    state.Write(state_header);
+
+    interconnect.SaveState(state, incremental);
+    arm9.SaveState(state);
+    arm7.SaveState(state);
+    state.Write(overshoot);
+    state.Write(slice_length);
+    state.Write(arm9_lead);
+    state.Write(arm7_lead);
+
+    state_header.size = u32(buffer.size() - sizeof(StateHeader));
+    memcpy(buffer.data(), &state_header, sizeof(StateHeader));
+  }
+
+  auto LoadState(std::vector<u8> const& buffer, bool trusted) -> bool {
+    StateHeader state_header;
+
+    if (buffer.size() < sizeof(StateHeader)) {
+      LOG_ERROR("Core: save state is too small.");
+      return false;
+    }
+    memcpy(&state_header, buffer.data(), sizeof(StateHeader));
+
+    if (state_header.magic != StateHeader::kMagic) {
+      LOG_ERROR("Core: not a save state.");
+      return false;
+    }
+
+    if (state_header.version != StateHeader::kVersion) {
+      LOG_ERROR("Core: save state version {0} is not supported (expected {1}).", state_header.version, StateHeader::kVersion);
+      return false;
+    }
+
+    if (state_header.size != buffer.size() - sizeof(StateHeader)) {
+      LOG_ERROR("Core: save state is truncated or corrupted.");
+      return false;
+    }
+
+    if (memcmp(state_header.game_code, header.game_code, sizeof(header.game_code)) != 0) {
+      LOG_ERROR("Core: save state was created for a different game.");
+      return false;
+    }
+
+    // The components load straight into the running core, so keep a copy of the
+    // current state around to go back to if the payload turns out to be corrupted.
+    if (!trusted) {
+      SaveState(rollback_state, false);
+    }
+
+    try {
+      LoadPayload(buffer);
+    } catch (StateError const& error) {
+      LOG_ERROR("Core: save state is corrupted: {0}", error.what());
+      if (!trusted) {
+        LoadPayload(rollback_state);
+      }
+      return false;
+    }
+    return true;
+  }
+
+  void LoadPayload(std::vector<u8> const& buffer) {
+    StateReader state{buffer.data() + sizeof(StateHeader), buffer.size() - sizeof(StateHeader)};
+    interconnect.LoadState(state);
+    arm9.LoadState(state);
+    arm7.LoadState(state);
+    state.Read(overshoot);
+    state.Check(overshoot <= kMaxSliceLength, "Core: bad overshoot in save state.");
+    state.Read(slice_length);
+    state.Check(slice_length >= kMinSliceLength && slice_length <= kMaxSliceLength, "Core: bad slice length in save state.");
+    state.Read(arm9_lead);
+    state.Read(arm7_lead);
+    state.Check(arm9_lead <= kMaxSliceLength * 2 && arm7_lead <= kMaxSliceLength, "Core: bad CPU lead in save state.");
+    state.Check(state.Remaining() == 0, "Core: unexpected data at the end of the save state.");
+  }
+
   void Run(uint cycles) {
     auto& scheduler = interconnect.scheduler;
-    auto& irq9 = interconnect.irq9;
+    auto& dma7 = interconnect.dma7;
+    auto& dma9 = interconnect.dma9;
 
     auto frame_target = scheduler.GetTimestampNow() + cycles - overshoot;
 
+    Tracer::Bind bind_tracer{tracer};
+    Profiler::Bind bind_profiler{profiler, Profiler::Thread::Emulation};
+
     while (scheduler.GetTimestampNow() < frame_target) {
       uint cycles = 1;
 
-      // Run both CPUs individually for up to 32 cycles, but make sure
+      // A CPU is stalled while its DMA controller owns the bus.
+      bool arm9_stalled = dma9.IsRunning();
+      bool arm7_stalled = dma7.IsRunning();
+      bool arm9_active = !arm9.IsHalted() && !arm9_stalled;
+      bool arm7_active = !arm7.IsHalted() && !arm7_stalled;
+
+      // Only worth the thread handoff if both CPUs have work to do.
+      // If one CPU is ahead (see below), the other one catches up on this thread first.
+      bool parallel = gRunCPUsInParallel && arm7_thread != nullptr && arm9_active && arm7_active &&
+                      arm9_lead == 0 && arm7_lead == 0;
+
+      // Run both CPUs individually for up to one slice, but make sure
       // that we do not run past any hardware event.
       if (gLooselySynchronizeCPUs) {
         u64 target = std::min(frame_target, scheduler.GetTimestampTarget());
-        // Run to the next event if both CPUs are halted.
-        // Otherwise run each CPU for up to 32 cycles.
+        // Run to the next event if both CPUs are halted or stalled.
+        // Otherwise run each CPU for up to one slice (but no more than the skew limit in parallel).
         cycles = target - scheduler.GetTimestampNow();
-        if (!arm9.IsHalted() || !arm7.IsHalted()) {
-          cycles = std::min(32U, cycles);
+        if (parallel) {
+          cycles = std::min({slice_length, uint(gParallelCPUSkew), cycles});
+        } else if (arm9_active || arm7_active) {
+          cycles = std::min(slice_length, cycles);
         }
       }
 
-      arm9.Run(cycles * 2);
-      arm7.Run(cycles);
+      // A CPU that was stopped early (e.g. because DMA took over the bus) has not used up its slice.
+      // Only advance the hardware as far as both CPUs got, whichever CPU got further
+      // keeps its lead and runs that much less in the next slice.
+      uint arm9_reached;
+      uint arm7_reached;
+
+      if (parallel) {
+        std::tie(arm9_reached, arm7_reached) = RunInParallel(cycles);
+      } else {
+        arm9_reached = RunCPU(arm9, arm9_stalled, cycles * 2, arm9_lead);
+        arm7_reached = RunCPU(arm7, arm7_stalled, cycles, arm7_lead);
+      }
+
+      cycles = std::min(arm9_reached / 2, arm7_reached);
+      arm9_lead = arm9_reached - cycles * 2;
+      arm7_lead = arm7_reached - cycles;
+
+      if (gLooselySynchronizeCPUs) {
+        UpdateSliceLength(cycles);
+      }
 
       scheduler.AddCycles(cycles);
       scheduler.Step();
     }
 
     overshoot = scheduler.GetTimestampNow() - frame_target;
+
+    if constexpr (gEnableProfiling) {
+      profiler.NextFrame();
+    }
+  }
+
+  /// Run a CPU until it is `target` cycles (of its own clock) ahead of the scheduler,
+  /// given that it already is `lead` cycles ahead. Returns how far ahead it got.
+  /// A stalled CPU just lets the time pass.
+  template<typename CPU>
+  static auto RunCPU(CPU& cpu, bool stalled, uint target, uint lead) -> uint {
+    if (stalled || lead >= target) {
+      return std::max(target, lead);
+    }
+    return lead + cpu.Run(target - lead);
+  }
+
+  /// The CPUs only need to run in lockstep while they talk to each other.
+  /// Double the slice length while neither CPU touches the shared registers,
+  /// and drop back to the minimum right after either one does.
+  void UpdateSliceLength(uint cycles) {
+    bool shared = interconnect.cpu_sync.TakeSharedIOAccess();
+
+    if (shared) {
+      slice_length = kMinSliceLength;
+    } else {
+      slice_length = std::min(slice_length * 2, kMaxSliceLength);
+    }
+
+    if constexpr (gEnableProfiling) {
+      profiler.AddSlice(cycles, shared);
+    }
+  }
+
+  /// Run the ARM7 on its own thread, while the ARM9 runs on this one.
+  /// Returns how far each CPU got, the same as RunCPU().
+  /// The ARM9 stops early if it has to wait for the ARM7 (see CPUSync::Defer()).
+  auto RunInParallel(uint cycles) -> std::pair<uint, uint> {
+    auto& cpu_sync = interconnect.cpu_sync;
+
+    cpu_sync.SetParallel(true);
+    arm7_thread->Run(cycles > arm7_lead ? cycles - arm7_lead : 0);
+    auto arm9_reached = RunCPU(arm9, false, cycles * 2, arm9_lead);
+    arm7_thread->Wait();
+    cpu_sync.SetParallel(false);
+
+    // Apply the memory map changes that had to wait for the ARM7 to stop.
+    cpu_sync.Flush();
+
+    return {arm9_reached, arm7_lead + arm7_executed};
   }
 
   void Load(std::string const& rom_path) {
     using Bus = arm::MemoryBase::Bus;
 
-    std::ifstream rom { rom_path, std::ios::in | std::ios::binary };
-    if (!rom.good()) {
+    auto t0 = std::chrono::steady_clock::now();
+
+    // Load cartridge ROM into Slot 1, the boot binaries are copied from the same mapping.
+    if (!interconnect.cart.Load(rom_path)) {
       throw std::runtime_error("failed to open ROM");
     }
+    auto& rom = interconnect.cart.GetROM();
 
-    rom.read((char*)&header, sizeof(Header));
-    if (!rom.good()) {
+    if (rom.Size() < sizeof(Header)) {
       throw std::runtime_error("failed to read ROM header, not enough data.");
     }
+    memcpy(&header, rom.Data(), sizeof(Header));
 
-    {
-      u8 data;
-      u32 dst = header.arm7.load_address;
-      rom.seekg(header.arm7.file_address);
-      for (u32 i = 0; i < header.arm7.size; i++) {
-        rom.read((char*)&data, 1);
-        if (!rom.good()) {
-          throw std::runtime_error("failed to read ARM7 binary from ROM into ARM7 memory");
-        }
-        arm7.Bus().WriteByte(dst++, data, Bus::Data);
-      }
-
-      arm7.Reset(header.arm7.entrypoint);
+    if (u64(header.arm7.file_address) + header.arm7.size > rom.Size()) {
+      throw std::runtime_error("failed to read ARM7 binary from ROM into ARM7 memory");
     }
+    CopyToGuest(arm7.Bus(), header.arm7.load_address, rom.Data() + header.arm7.file_address, header.arm7.size);
+    arm7.Reset(header.arm7.entrypoint);
 
-    {
-      u8 data;
-      u32 dst = header.arm9.load_address;
-      rom.seekg(header.arm9.file_address);
-      for (u32 i = 0; i < header.arm9.size; i++) {
-        rom.read((char*)&data, 1);
-        if (!rom.good()) {
-          throw std::runtime_error("failed to read ARM9 binary from ROM into ARM9 memory");
-        }
-        arm9.Bus().WriteByte(dst++, data, Bus::Data);
-      }
-
-      arm9.Reset(header.arm9.entrypoint);
+    if (u64(header.arm9.file_address) + header.arm9.size > rom.Size()) {
+      throw std::runtime_error("failed to read ARM9 binary from ROM into ARM9 memory");
     }
+    CopyToGuest(arm9.Bus(), header.arm9.load_address, rom.Data() + header.arm9.file_address, header.arm9.size);
+    arm9.Reset(header.arm9.entrypoint);
 
-    u8 data;
-    u32 dst = 0x02FFFE00;
-    rom.seekg(0);
-    for (u32 i = 0; i < 0x170; i++) {
-      rom.read((char*)&data, 1);
-      if (!rom.good()) {
-        throw std::runtime_error("failed to load cartridge header into memory");
-      }
-      arm9.Bus().WriteByte(dst++, data, Bus::Data);
+    if (rom.Size() < 0x170) {
+      throw std::runtime_error("failed to load cartridge header into memory");
     }
-
-    rom.close();
-
-    // Load cartridge ROM into Slot 1
-    interconnect.cart.Load(rom_path);
+    CopyToGuest(arm9.Bus(), 0x02FFFE00, rom.Data(), 0x170);
 
     // Huge thanks to Hydr8gon for pointing this out:
     arm9.Bus().WriteWord(0x027FF800, 0x1FC2, Bus::Data); // Chip ID 1
@@ -159,14 +370,73 @@ struct CoreImpl {
     arm9.Bus().WriteWord(0x027FFC04, 0x1FC2, Bus::Data); // Copy of chip ID 2
     arm9.Bus().WriteHalf(0x027FFC10, 0x5835, Bus::Data); // Copy of ARM7 BIOS CRC
     arm9.Bus().WriteHalf(0x027FFC40, 0x0001, Bus::Data); // Boot indicator
+
+    auto t1 = std::chrono::steady_clock::now();
+    LOG_INFO("Core: loaded ROM in {0} ms ({1} KiB ARM9, {2} KiB ARM7 binary)",
+      std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count(),
+      header.arm9.size / 1024, header.arm7.size / 1024);
   }
 
+  /// Copies a block of data into guest memory. Memory pages that are
+  /// directly writable through the fast memory pagetable are copied in bulk,
+  /// everything else (MMIO, TCM) goes through the regular bus.
+  static void CopyToGuest(arm::MemoryBase& memory, u32 address, u8 const* data, u32 size) {
+    using Bus = arm::MemoryBase::Bus;
+
+    auto overlaps_tcm = [&](arm::MemoryBase::TCM const& tcm, u32 address_lo, u32 address_hi) {
+      return tcm.config.enable && address_lo <= tcm.config.limit && address_hi >= tcm.config.base;
+    };
+
+    while (size != 0) {
+      auto chunk = std::min<u32>(size, arm::MemoryBase::kPageMask + 1 - (address & arm::MemoryBase::kPageMask));
+      auto address_hi = address + chunk - 1;
+      u8* page = nullptr;
+
+      if (memory.write_pagetable != nullptr &&
+          !overlaps_tcm(memory.itcm, address, address_hi) &&
+          !overlaps_tcm(memory.dtcm, address, address_hi)) {
+        page = (*memory.write_pagetable)[address >> arm::MemoryBase::kPageShift];
+      }
+
+      if (page != nullptr) {
+        memcpy(page + (address & arm::MemoryBase::kPageMask), data, chunk);
+      } else {
+        for (u32 i = 0; i < chunk; i++) {
+          memory.WriteByte(address + i, data[i], Bus::Data);
+        }
+      }
+
+      address += chunk;
+      data += chunk;
+      size -= chunk;
+    }
+  }
+
+  /// Bounds of the CPU slice length in ARM7 cycles, see UpdateSliceLength().
+  static constexpr uint kMinSliceLength = 16;
+  static constexpr uint kMaxSliceLength = 256;
+
   u64 overshoot = 0;
+  uint slice_length = kMinSliceLength;
+
+  /// How many cycles each CPU ran past the scheduler's time, in its own clock cycles.
+  uint arm9_lead = 0;
+  uint arm7_lead = 0;
+
+  /// Reused by LoadState(), so that loading repeatedly does not reallocate.
+  std::vector<u8> rollback_state;
 
   Interconnect interconnect;
   ARM7 arm7;
   ARM9 arm9;
   Header header;
+  Tracer tracer{interconnect.scheduler};
+  Profiler profiler;
+
+  /// Runs the ARM7 if gRunCPUsInParallel is set and the host has more than one core.
+  std::unique_ptr<CPUThread> arm7_thread;
+  /// Result of the last ARM7::Run() on the ARM7 thread.
+  uint arm7_executed = 0;
 };
 
 Core::Core(std::string const& rom_path) {
@@ -197,4 +467,32 @@ void Core::Run(uint cycles) {
   pimpl->Run(cycles);
 }
 
+void Core::SyncStorage() {
+  pimpl->SyncStorage();
+}
+
+void Core::SaveState(std::vector<u8>& buffer) {
+  pimpl->SaveState(buffer, false);
+}
+
+void Core::SaveStateIncremental(std::vector<u8>& buffer) {
+  pimpl->SaveState(buffer, true);
+}
+
+auto Core::LoadState(std::vector<u8> const& buffer) -> bool {
+  return pimpl->LoadState(buffer, false);
+}
+
+auto Core::LoadStateTrusted(std::vector<u8> const& buffer) -> bool {
+  return pimpl->LoadState(buffer, true);
+}
+
+void Core::StartTrace(std::string const& path) {
+  pimpl->StartTrace(path);
+}
+
+void Core::StopTrace() {
+  pimpl->StopTrace();
+}
+
 } // namespace Duality::Core
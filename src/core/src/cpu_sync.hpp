@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <atomic>
+#include <buildconfig.hpp>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "arm/arm.hpp"
+
+namespace Duality::Core {
+
+/// Keeps shared hardware consistent while the ARM9 and ARM7 run on separate threads
+/// (see gRunCPUsInParallel). Does nothing while the CPUs run one after another.
+/// Also notes when the CPUs talk to each other, which CoreImpl uses to pick the slice length.
+struct CPUSync {
+  using Callback = std::function<void(void)>;
+
+  /// Minimal spin lock, I/O handlers only hold it for a few hundred nanoseconds.
+  struct SpinLock {
+    void lock() {
+      while (locked.exchange(true, std::memory_order_acquire)) {
+        while (locked.load(std::memory_order_relaxed)) {
+#if defined(__x86_64__) || defined(__i386__)
+          __builtin_ia32_pause();
+#endif
+        }
+      }
+    }
+
+    void unlock() {
+      locked.store(false, std::memory_order_release);
+    }
+
+  private:
+    std::atomic<bool> locked = false;
+  };
+
+  void SetCore(arm::ARM& core) { this->core = &core; }
+
+  /// Must only be called while both CPUs are stopped.
+  void SetParallel(bool parallel) { this->parallel = parallel; }
+
+  /// I/O registers are shared between both CPUs (IPC, IRQ, the scheduler, ...),
+  /// so all I/O accesses are serialized while the CPUs run in parallel.
+  auto LockIO() -> std::unique_lock<SpinLock> {
+    if (gRunCPUsInParallel && parallel) {
+      return std::unique_lock<SpinLock>{io_lock};
+    }
+    return {};
+  }
+
+  /// Run a register write that remaps memory of the other CPU (WRAMCNT, VRAMCNT C/D).
+  /// While the CPUs run in parallel the write is deferred until both of them are stopped,
+  /// and the writing CPU (see SetCore()) stops after the current instruction.
+  void Defer(Callback callback) {
+    if (gRunCPUsInParallel && parallel) {
+      deferred.push_back(std::move(callback));
+      core->Stop();
+    } else {
+      callback();
+    }
+  }
+
+  /// Note accesses to the registers that the CPUs use to talk to each other:
+  /// IPC, cartridge (either CPU may own the slot), VRAMCNT/WRAMCNT and VRAMSTAT/WRAMSTAT.
+  void OnIOAccess(u32 address) {
+    if ((address >= 0x04000180 && address < 0x040001C0) ||
+        (address >= 0x04000240 && address < 0x04000248) ||
+        (address >= 0x04100000 && address < 0x04100020)) {
+      shared_io_accessed = true;
+    }
+  }
+
+  /// Returns whether shared registers were accessed since the previous call.
+  /// Must only be called while both CPUs are stopped.
+  bool TakeSharedIOAccess() {
+    auto accessed = shared_io_accessed;
+    shared_io_accessed = false;
+    return accessed;
+  }
+
+  /// Apply the deferred writes, must only be called while both CPUs are stopped.
+  void Flush() {
+    for (auto const& callback : deferred) callback();
+    deferred.clear();
+  }
+
+private:
+  arm::ARM* core = nullptr;
+  bool parallel = false;
+  bool shared_io_accessed = false;
+  SpinLock io_lock;
+  std::vector<Callback> deferred;
+};
+
+} // namespace Duality::Core
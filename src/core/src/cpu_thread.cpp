@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include "cpu_thread.hpp"
+
+namespace Duality::Core {
+
+/// Wait a little before polling again. Gives up the time slice once the
+/// wait gets longer, in case the other thread shares the same host core.
+static inline void Backoff(int& iteration) {
+  if (++iteration < 256) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+    return;
+  }
+  std::this_thread::yield();
+}
+
+CPUThread::CPUThread(Function function) : function(function) {
+  thread = std::thread{[this]() { ThreadMain(); }};
+}
+
+CPUThread::~CPUThread() {
+  {
+    std::lock_guard guard{lock};
+    quit = true;
+  }
+  cv.notify_one();
+  thread.join();
+}
+
+void CPUThread::Run(uint cycles) {
+  this->cycles = cycles;
+  requested.fetch_add(1, std::memory_order_seq_cst);
+
+  // Pairs with the check in ThreadMain(): either the worker sees the new slice
+  // before it goes to sleep, or we see that it sleeps and wake it up.
+  if (sleeping.load(std::memory_order_seq_cst)) {
+    std::lock_guard guard{lock};
+    cv.notify_one();
+  }
+}
+
+void CPUThread::Wait() {
+  auto slice = requested.load(std::memory_order_relaxed);
+  int iteration = 0;
+
+  while (completed.load(std::memory_order_acquire) != slice) {
+    Backoff(iteration);
+  }
+}
+
+void CPUThread::ThreadMain() {
+  u64 slice = 0;
+
+  while (true) {
+    int iteration = 0;
+
+    while (iteration < kSpinCount && requested.load(std::memory_order_acquire) == slice) {
+      Backoff(iteration);
+    }
+
+    if (requested.load(std::memory_order_acquire) == slice) {
+      std::unique_lock guard{lock};
+      sleeping.store(true, std::memory_order_seq_cst);
+      cv.wait(guard, [&]() {
+        return quit || requested.load(std::memory_order_seq_cst) != slice;
+      });
+      sleeping.store(false, std::memory_order_relaxed);
+      if (quit) break;
+    }
+
+    slice++;
+    function(cycles);
+    completed.store(slice, std::memory_order_release);
+  }
+}
+
+} // namespace Duality::Core
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <util/integer.hpp>
+
+namespace Duality::Core {
+
+/// Runs a CPU on a dedicated host thread, one slice at a time.
+/// The owner hands out a slice with Run() and waits for it to complete with Wait().
+/// Slices only take a few microseconds of host time, so both sides spin while waiting.
+/// The worker goes to sleep if it did not get a new slice for a while (e.g. between frames).
+struct CPUThread {
+  using Function = std::function<void(uint)>;
+
+  CPUThread(Function function);
+ ~CPUThread();
+
+  /// Start running the next slice of `cycles` cycles.
+  /// Everything written before the call is visible to the CPU thread.
+  void Run(uint cycles);
+
+  /// Block until the current slice completed.
+  /// Everything written by the CPU thread is visible afterwards.
+  void Wait();
+
+private:
+  /// Number of polls before the worker goes to sleep.
+  static constexpr int kSpinCount = 4096;
+
+  void ThreadMain();
+
+  Function function;
+
+  std::atomic<u64> requested = 0;
+  std::atomic<u64> completed = 0;
+  uint cycles = 0;
+
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable cv;
+  std::atomic<bool> sleeping = false;
+  std::atomic<bool> quit = false;
+};
+
+} // namespace Duality::Core
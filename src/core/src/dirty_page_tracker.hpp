@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <memory>
+#include <string.h>
+#include <util/integer.hpp>
+#include <util/log.hpp>
+#include <vector>
+
+#include "save_state.hpp"
+
+namespace Duality::Core {
+
+/// Keeps track of which 4 KiB pages of guest RAM were written to since the
+/// last incremental snapshot, so that the snapshot only needs to store those.
+/// Every page has a flag byte, so that marking a page as dirty is a single store.
+struct DirtyPageTracker {
+  static constexpr int kPageShift = 12;
+  static constexpr size_t kPageSize = 1 << kPageShift;
+
+  /// Register a block of host memory for tracking.
+  /// Must happen before any flag pointer is handed out via GetFlag().
+  void AddRegion(u8* data, size_t size) {
+    ASSERT((size & (kPageSize - 1)) == 0, "DirtyPageTracker: region size must be a multiple of the page size.");
+
+    auto page_count = size >> kPageShift;
+    auto flags = std::make_unique<u8[]>(page_count);
+    memset(flags.get(), 1, page_count);
+    regions.push_back({data, page_count, std::move(flags)});
+  }
+
+  /// Get the flag for the page that contains the given host address.
+  /// Untracked memory gets a shared scratch flag, so that callers never need to check for nullptr.
+  auto GetFlag(void const* address) -> u8* {
+    auto byte = static_cast<u8 const*>(address);
+
+    if (byte != nullptr) {
+      for (auto& region : regions) {
+        if (byte >= region.data && byte < region.data + (region.page_count << kPageShift)) {
+          return &region.flags[(byte - region.data) >> kPageShift];
+        }
+      }
+    }
+
+    return &scratch_flag;
+  }
+
+  void Mark(void const* address) {
+    *GetFlag(address) = 1;
+  }
+
+  void MarkAll() {
+    for (auto& region : regions) memset(region.flags.get(), 1, region.page_count);
+  }
+
+  /// Load all pages contained in a full or incremental snapshot.
+  /// Afterwards every page counts as dirty, because the state of guest memory
+  /// does not necessarily match the previous incremental snapshot anymore.
+  void LoadState(StateReader& state) {
+    for (auto& region : regions) {
+      if (state.Read<u8>() != 0) {
+        state.Read(region.data, region.page_count << kPageShift);
+      } else {
+        state.Read(region.flags.get(), region.page_count);
+        ForEachRun(region, [&](size_t first, size_t count) {
+          state.Read(region.data + (first << kPageShift), count << kPageShift);
+        });
+      }
+    }
+    MarkAll();
+  }
+
+  /// Store either all tracked pages or only the dirty ones.
+  /// Incremental snapshots reset the dirty flags, full snapshots leave them untouched.
+  void SaveState(StateWriter& state, bool incremental) {
+    for (auto& region : regions) {
+      // Each region begins with a byte that tells whether it is stored completely.
+      if (!incremental) {
+        state.Write(u8(1));
+        state.Write(region.data, region.page_count << kPageShift);
+      } else {
+        state.Write(u8(0));
+        state.Write(region.flags.get(), region.page_count);
+        ForEachRun(region, [&](size_t first, size_t count) {
+          state.Write(region.data + (first << kPageShift), count << kPageShift);
+        });
+        memset(region.flags.get(), 0, region.page_count);
+      }
+    }
+  }
+
+  /// Number of dirty pages across all regions.
+  auto GetDirtyPageCount() const -> size_t {
+    size_t count = 0;
+    for (auto const& region : regions) {
+      for (size_t i = 0; i < region.page_count; i++) count += region.flags[i];
+    }
+    return count;
+  }
+
+private:
+  struct Region {
+    u8* data;
+    size_t page_count;
+    std::unique_ptr<u8[]> flags;
+  };
+
+  /// Invoke the functor for each run of consecutive dirty pages,
+  /// so that the pages can be copied with as few memcpys as possible.
+  template<typename Functor>
+  static void ForEachRun(Region& region, Functor functor) {
+    size_t i = 0;
+
+    while (i < region.page_count) {
+      if (region.flags[i] == 0) {
+        i++;
+        continue;
+      }
+
+      auto first = i;
+      while (i < region.page_count && region.flags[i] != 0) i++;
+      functor(first, i - first);
+    }
+  }
+
+  std::vector<Region> regions;
+  u8 scratch_flag = 0;
+};
+
+} // namespace Duality::Core
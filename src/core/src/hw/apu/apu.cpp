@@ -4,15 +4,20 @@
 
 
 #include <algorithm>
+#include <buildconfig.hpp>
+#include <cmath>
 #include <util/log.hpp>
 //#include <SDL.h>
 #include <string.h>
 
 #include "apu.hpp"
+#include "profiler.hpp"
 
 namespace Duality::Core {
 
-static constexpr float kVolumeDivideLUT[4] { 1.0, 1.0 / 2.0, 1.0 / 4.0, 1.0 / 16.0 };
+/// The volume divider (1, 2, 4 or 16) is applied to the sample
+/// as a 16.4 fixed-point number, so it is a left shift by these amounts.
+static constexpr int kVolumeShiftLUT[4] { 4, 3, 2, 0 };
 
 static constexpr int kAdpcmIndexTab[8] { -1, -1, -1, -1, 2, 4, 6, 8 };
 
@@ -32,6 +37,8 @@ static constexpr s16 kAdpcmTable[89] {
 };
 
 APU::APU(Scheduler& scheduler) : scheduler(scheduler) {
+  scheduler.Register(Scheduler::EventClass::APU_StepMixer, this, &APU::StepMixer);
+
   Reset();
 }
 
@@ -46,12 +53,33 @@ void APU::Reset() {
     channels[i] = {};
   }
 
-  memset(&buffer, 0, sizeof(buffer));
-  buffer_rd_pos = 0;
-  buffer_wr_pos = 0;
-  buffer_count = 0;
+  // NOTE: the buffer is not cleared, it belongs to the audio thread
+  // and only holds a few milliseconds of already mixed output.
+  mixer_timestamp = scheduler.GetTimestampNow() + kCyclesPerSample;
+
+  scheduler.Add(kCyclesPerSample * kMixerBatchSize, Scheduler::EventClass::APU_StepMixer);
+}
+
+void APU::LoadState(StateReader& state) {
+  state.Read(channels);
+  state.Read(mixer_timestamp);
+
+  for (uint i = 0; i < 16; i++) {
+    auto const& channel = channels[i];
+
+    state.Check(channel.volume_mul >= 0 && channel.volume_mul <= 127 && channel.volume_div >= 0 && channel.volume_div <= 3, "APU: bad volume in save state.");
+    state.Check(channel.panning >= 0 && channel.panning <= 127 && channel.psg_wave_duty >= 0 && channel.psg_wave_duty <= 7, "APU: bad channel control in save state.");
+    state.Check(channel.repeat_mode >= Channel::RepeatMode::Manual && channel.repeat_mode <= Channel::RepeatMode::Prohibited, "APU: bad repeat mode in save state.");
+    state.Check(channel.format >= Channel::Format::PCM8 && channel.format <= Channel::Format::PSG, "APU: bad format in save state.");
+    state.Check(channel.format != Channel::Format::PSG || i >= 8, "APU: bad format in save state.");
+    state.Check(channel.adpcm_index >= 0 && channel.adpcm_index <= 88, "APU: bad ADPCM index in save state.");
+    state.Check(channel.t >= 0 && channel.t < 8, "APU: bad sample position in save state.");
+  }
+}
 
-  scheduler.Add(1024, this, &APU::StepMixer);
+void APU::SaveState(StateWriter& state) {
+  state.Write(channels);
+  state.Write(mixer_timestamp);
 }
 
 void APU::SetAudioDevice(AudioDevice& device) {
@@ -59,12 +87,15 @@ void APU::SetAudioDevice(AudioDevice& device) {
     audio_device->Close();
   }
   audio_device = &device;
-  audio_device->Open(this, (AudioDevice::Callback)AudioCallback, 32768, 2048);
+  audio_device->Open(this, (AudioDevice::Callback)AudioCallback, kOutputRate, kOutputBlockSize);
 }
 
 auto APU::Read(uint chan_id, uint offset) -> u8 {
   auto const& channel = channels[chan_id];
 
+  // One-shot channels clear the start bit once they reach the end.
+  Update(chan_id);
+
   switch (offset) {
     case REG_SOUNDXCNT|0: {
       return channel.volume_mul;
@@ -88,7 +119,8 @@ auto APU::Read(uint chan_id, uint offset) -> u8 {
 
 void APU::Write(uint chan_id, uint offset, u8 value) {
   auto& channel = channels[chan_id];
-  auto timer_duty_old = channel.timer_duty;
+
+  Update(chan_id);
 
   switch (offset) {
     case REG_SOUNDXCNT|0: {
@@ -133,16 +165,11 @@ void APU::Write(uint chan_id, uint offset, u8 value) {
           channel.noise_lfsr = 0x7FFF;
         }
 
-        auto delay = 2 * (0x10000 - channel.timer_duty);
-        channel.event = scheduler.Add(delay, [chan_id, this](int cycles_late) {
-          StepChannel(chan_id, cycles_late);
-        });
+        channel.timestamp = scheduler.GetTimestampNow() + 2 * (0x10000 - channel.timer_duty);
       }
 
       if (channel.running && !(value & 0x80)) {
         channel.running = false;
-        scheduler.Cancel(channel.event);
-        channel.event = nullptr;
       }
       break;
     }
@@ -186,30 +213,158 @@ void APU::Write(uint chan_id, uint offset, u8 value) {
   }
 }
 
-void APU::StepMixer(int cycles_late) {
-  float samples[2] { };
+auto APU::ReadHalf(uint chan_id, uint offset) -> u16 {
+  return Read(chan_id, offset | 0) | (Read(chan_id, offset | 1) << 8);
+}
 
-  for (auto const& channel : channels) {
-    // TODO: interpret volume_mul = 127 as 128.
-    float sample = channel.sample * channel.volume_mul * kVolumeDivideLUT[channel.volume_div] / 128.0;
-    samples[0] += sample * channel.panning / 128.0;
-    samples[1] += sample * (127.0 - channel.panning) / 128.0;
+auto APU::ReadWord(uint chan_id, uint offset) -> u32 {
+  return ReadHalf(chan_id, offset | 0) | (ReadHalf(chan_id, offset | 2) << 16);
+}
+
+void APU::WriteHalf(uint chan_id, uint offset, u16 value) {
+  auto& channel = channels[chan_id];
+
+  Update(chan_id);
+
+  switch (offset) {
+    case REG_SOUNDXTMR: {
+      channel.timer_duty = value;
+      break;
+    }
+    case REG_SOUNDXPNT: {
+      channel.loop_start = value;
+      break;
+    }
+    default: {
+      Write(chan_id, offset | 0, u8(value));
+      Write(chan_id, offset | 1, u8(value >> 8));
+      break;
+    }
   }
+}
 
-  std::lock_guard<std::mutex> guard { buffer_lock };
-  
-  for (int i = 0; i < 2; i++) {
-    s16 sample_s16 = std::clamp(samples[i] * 32767.0, -32767.0, +32767.0);
-    buffer[i][buffer_wr_pos] = sample_s16;
+void APU::WriteWord(uint chan_id, uint offset, u32 value) {
+  auto& channel = channels[chan_id];
+
+  Update(chan_id);
+
+  switch (offset) {
+    case REG_SOUNDXSAD: {
+      channel.src_address = value & 0x07FFFFFC;
+      break;
+    }
+    case REG_SOUNDXTMR: {
+      channel.timer_duty = u16(value);
+      channel.loop_start = u16(value >> 16);
+      break;
+    }
+    case REG_SOUNDXLEN: {
+      channel.length = value & 0x003FFFFF;
+      break;
+    }
+    default: {
+      // SOUNDxCNT: the start bit is in the last byte, so that the channel
+      // starts with the volume, panning and format written by the same access.
+      WriteHalf(chan_id, offset | 0, u16(value));
+      WriteHalf(chan_id, offset | 2, u16(value >> 16));
+      break;
+    }
   }
+}
 
-  buffer_wr_pos = (buffer_wr_pos + 1) % kRingBufferSize;
-  buffer_count++;
+void APU::Update(uint chan_id) {
+  auto now = scheduler.GetTimestampNow();
 
-  scheduler.Add(1024 - cycles_late, this, &APU::StepMixer);
+  // Mix the output samples up to now, which must happen
+  // before e.g. the volume changes, then bring the channel itself up to date.
+  Mix(now);
+  GenerateSamples(chan_id, now);
 }
 
-void APU::StepChannel(uint chan_id, int cycles_late) {
+void APU::Mix(u64 timestamp) {
+  Profiler::Scope scope{Profiler::Section::APU_Mixer};
+
+  while (mixer_timestamp <= timestamp) {
+    auto count = int(std::min<u64>((timestamp - mixer_timestamp) / kCyclesPerSample + 1, kMixerBatchSize));
+
+    // 20.8 fixed-point sums of all channels
+    s32 left [kMixerBatchSize] { };
+    s32 right[kMixerBatchSize] { };
+
+    for (uint i = 0; i < 16; i++) {
+      MixChannel(i, count, left, right);
+    }
+
+    Frame batch[kMixerBatchSize];
+
+    // TODO: apply the master volume (SOUNDCNT) and output bias (SOUNDBIAS),
+    // the hardware finally clips the result to 10-bit.
+    for (int i = 0; i < count; i++) {
+      batch[i].left  = s16(std::clamp(left [i] >> 8, -0x8000, +0x7FFF));
+      batch[i].right = s16(std::clamp(right[i] >> 8, -0x8000, +0x7FFF));
+    }
+
+    // Samples are dropped if the audio thread does not keep up, e.g. while fast-forwarding.
+    buffer.Write(batch, count);
+
+    mixer_timestamp += count * kCyclesPerSample;
+  }
+}
+
+void APU::MixChannel(uint chan_id, int count, s32* left, s32* right) {
+  auto const& channel = channels[chan_id];
+
+  // Output of the channel at each output sample of the block
+  s32 samples[kMixerBatchSize];
+
+  for (int i = 0; i < count; i++) {
+    GenerateSamples(chan_id, mixer_timestamp + i * kCyclesPerSample);
+    samples[i] = channel.sample;
+  }
+
+  if (channel.volume_mul == 0) {
+    return;
+  }
+
+  // Volume and panning are factors of N/128, where N = 127 counts as 128.
+  // Panning goes from 0 (left) to 127 (right).
+  s32 volume = (channel.volume_mul == 127 ? 128 : channel.volume_mul) << kVolumeShiftLUT[channel.volume_div];
+  s32 pan_right = channel.panning == 127 ? 128 : channel.panning;
+  s32 pan_left  = 128 - pan_right;
+
+  // Same precision as the hardware: the 16.11 volume-scaled sample is multiplied
+  // with the panning factor to 16.18 and rounded down to 16.8. The 16.18 product
+  // does not fit into 32-bit, so the multiplication is split at the bits that are stripped.
+  // The loop has no branches, so that the compiler can vectorize it.
+  for (int i = 0; i < count; i++) {
+    s32 sample = samples[i] * volume;
+    s32 upper  = sample >> 10;
+    s32 lower  = sample & 0x3FF;
+
+    left [i] += upper * pan_left  + ((lower * pan_left ) >> 10);
+    right[i] += upper * pan_right + ((lower * pan_right) >> 10);
+  }
+}
+
+void APU::GenerateSamples(uint chan_id, u64 timestamp) {
+  auto& channel = channels[chan_id];
+
+  // NOTE: the sample period may change with each sample (SOUNDxTMR writes).
+  while (channel.running && channel.timestamp <= timestamp) {
+    StepChannel(chan_id);
+    channel.timestamp += 2 * (0x10000 - channel.timer_duty);
+  }
+}
+
+void APU::StepMixer(int cycles_late) {
+  auto now = scheduler.GetTimestampNow() - cycles_late;
+
+  Mix(now);
+
+  scheduler.Add(kCyclesPerSample * kMixerBatchSize - cycles_late, Scheduler::EventClass::APU_StepMixer);
+}
+
+void APU::StepChannel(uint chan_id) {
   auto& channel = channels[chan_id];
 
   if (channel.format == Channel::Format::PSG) {
@@ -217,9 +372,9 @@ void APU::StepChannel(uint chan_id, int cycles_late) {
   
     if (chan_id <= 13) {
       if (channel.t < (7 - channel.psg_wave_duty)) {
-        channel.sample = -1.0;
+        channel.sample = -0x7FFF;
       } else {
-        channel.sample = +1.0;
+        channel.sample = +0x7FFF;
       }
 
       if (++channel.t == 8) channel.t = 0;
@@ -228,9 +383,9 @@ void APU::StepChannel(uint chan_id, int cycles_late) {
       channel.noise_lfsr >>= 1;
       if (carry) {
         channel.noise_lfsr ^= 0x6000;
-        channel.sample = -1.0;
+        channel.sample = -0x7FFF;
       } else {
-        channel.sample = +1.0;
+        channel.sample = +0x7FFF;
       }
     }
   } else {
@@ -244,13 +399,13 @@ void APU::StepChannel(uint chan_id, int cycles_late) {
 
     switch (channel.format) {
       case Channel::Format::PCM8: {
-        channel.sample = s8(channel.latch & 0xFF) / 128.0;
+        channel.sample = s16(channel.latch << 8);
         channel.latch >>= 8;
         channel.t += 2;
         break;
       }
       case Channel::Format::PCM16: {
-        channel.sample = s16(channel.latch & 0xFFFF) / 32768.0;
+        channel.sample = s16(channel.latch);
         channel.latch >>= 16;
         channel.t += 4;
         break;
@@ -272,7 +427,7 @@ void APU::StepChannel(uint chan_id, int cycles_late) {
         }
 
         channel.adpcm_index = std::clamp(channel.adpcm_index + kAdpcmIndexTab[data & 7], 0, 88);
-        channel.sample = channel.adpcm_sample / 32768.0;
+        channel.sample = channel.adpcm_sample;
         channel.t++;
         break;
       }
@@ -307,37 +462,57 @@ void APU::StepChannel(uint chan_id, int cycles_late) {
       }
     }
   }
-
-  if (channel.running) {
-    auto delay = 2 * (0x10000 - channel.timer_duty);
-    channel.event = scheduler.Add(delay - cycles_late, [chan_id, this](int cycles_late) {
-      StepChannel(chan_id, cycles_late);
-    });
-  } else {
-    channel.event = nullptr;
-  }
 }
 
 void AudioCallback(APU* this_, s16* stream, int length) {
-  int num_samples = length / sizeof(s16) / 2;
-  std::lock_guard<std::mutex> guard { this_->buffer_lock };
-
-  if (this_->buffer_count >= num_samples) {
-    for (int i = 0; i < num_samples; i++) {
-      *stream++ = this_->buffer[0][this_->buffer_rd_pos];
-      *stream++ = this_->buffer[1][this_->buffer_rd_pos];
-      this_->buffer_rd_pos = (this_->buffer_rd_pos + 1) % APU::kRingBufferSize;
-      this_->buffer_count--;
-    }
-  } else {
-    int j = 0;
+  auto& resampler = this_->resampler;
+  auto output_count = int(length / sizeof(s16) / 2);
+  auto output_rate = this_->audio_device->GetSampleRate();
 
-    for (int i = 0; i < num_samples; i++) {
-      *stream++ = this_->buffer[0][this_->buffer_rd_pos + j];
-      *stream++ = this_->buffer[1][this_->buffer_rd_pos + j];
-      if (++j == this_->buffer_count) j = 0;
-    }
+  if (resampler.GetOutputRate() != output_rate) {
+    auto quality = gUseSincResampler ? Resampler::Quality::Sinc : Resampler::Quality::Linear;
+    resampler.Configure(APU::kSampleRate, output_rate, quality);
+  }
+
+  // Dynamic rate control: take slightly more or less input than the nominal ratio asks for,
+  // depending on how far the (smoothed) buffer fill level is from the target.
+  // This keeps the latency low, without under- or overruns from small differences in clock speed.
+  // A constant difference is learned over time (rate_correction), so that the fill level settles at the target.
+  auto available = this_->buffer.Count();
+  auto ratio = double(APU::kSampleRate) / output_rate;
+  auto target = output_count * ratio + APU::kBufferFillMargin;
+  auto& average_fill = this_->average_fill;
+  auto& rate_correction = this_->rate_correction;
+  auto& position = this_->input_position;
+
+  if (available > APU::kBufferOverfillFactor * target) {
+    available -= this_->buffer.Discard(available - std::size_t(target));
+    average_fill = double(available);
   }
+
+  average_fill += (available - average_fill) * 0.05;
+
+  auto error = std::clamp((average_fill - target) / target, -1.0, +1.0);
+
+  rate_correction = std::clamp(rate_correction + error * APU::kRateCorrectionGain,
+    -APU::kMaxRateDeviation, +APU::kMaxRateDeviation);
+
+  auto deviation = std::clamp(rate_correction + error * APU::kMaxRateDeviation,
+    -APU::kMaxRateDeviation, +APU::kMaxRateDeviation);
+
+  position += output_count * ratio * (1.0 + deviation);
+
+  auto wanted = std::min(std::size_t(position), std::size_t(Resampler::kMaxInputFrames));
+  auto input_count = this_->buffer.Read(resampler.GetInputBuffer(), wanted);
+
+  if (input_count < wanted) {
+    // Underrun: stretch whatever is available over the whole block and forget about the rest.
+    position -= std::floor(position);
+  } else {
+    position -= input_count;
+  }
+
+  resampler.Process(int(input_count), stream, output_count);
 }
 
 } // namespace Duality::Core
@@ -5,10 +5,11 @@
 #pragma once
 
 #include <util/integer.hpp>
+#include <util/spsc_ring.hpp>
 #include <core/device/audio_device.hpp>
-#include <mutex>
 
 #include "arm/memory.hpp"
+#include "resampler.hpp"
 #include "scheduler.hpp"
 
 namespace Duality::Core {
@@ -20,16 +21,55 @@ struct APU {
  ~APU();
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   void SetMemory(arm::MemoryBase* memory) { this->memory = memory; }
   void SetAudioDevice(AudioDevice& device);
   auto Read (uint chan_id, uint offset) -> u8;
   void Write(uint chan_id, uint offset, u8 value);
 
+  /// Native 16-bit and 32-bit accesses, e.g. the sound driver updating SOUNDxTMR or SOUNDxCNT.
+  auto ReadHalf (uint chan_id, uint offset) -> u16;
+  auto ReadWord (uint chan_id, uint offset) -> u32;
+  void WriteHalf(uint chan_id, uint offset, u16 value);
+  void WriteWord(uint chan_id, uint offset, u32 value);
+
 private:
   friend void Duality::Core::AudioCallback(APU* this_, s16* stream, int length);
 
   static constexpr int kRingBufferSize = 8192;
 
+  /// The mixer outputs one sample every 1024 cycles (32768 Hz),
+  /// but only runs once for every kMixerBatchSize samples.
+  static constexpr int kCyclesPerSample = 1024;
+  static constexpr int kMixerBatchSize = 16;
+
+  /// Native rate of the mixer output.
+  static constexpr uint kSampleRate = 32768;
+
+  /// Requested from the audio device, which may pick another rate (e.g. its native one).
+  /// Either way the output is resampled to the rate of the device.
+  static constexpr uint kOutputRate = 48000;
+  static constexpr uint kOutputBlockSize = 256;
+
+  /// The emulator thread produces the samples of a whole video frame (about 550) in one go,
+  /// so the buffer should hold this many samples in addition to one output block.
+  static constexpr int kBufferFillMargin = 640;
+
+  /// Skip ahead to the target fill level once the buffer holds this many times as much,
+  /// e.g. while fast-forwarding. Catching up with the rate control would take ages.
+  static constexpr int kBufferOverfillFactor = 3;
+
+  /// Dynamic rate control changes the resampling ratio by at most this much,
+  /// which keeps the pitch change inaudible.
+  static constexpr double kMaxRateDeviation = 0.005;
+
+  /// How quickly dynamic rate control learns a constant clock difference
+  /// between the emulator and the audio device.
+  static constexpr double kRateCorrectionGain = 0.00005;
+
+  using Frame = Resampler::Frame;
+
   enum Registers {
     REG_SOUNDXCNT = 0x0,
     REG_SOUNDXSAD = 0x4,
@@ -68,7 +108,7 @@ private:
     u32 length = 0;
 
     // internal
-    float sample;
+    s16 sample;
     s16 adpcm_sample;
     int adpcm_index;
     u32 adpcm_header;
@@ -76,17 +116,29 @@ private:
     int t;
     u32 latch;
     u32 noise_lfsr;
-    Scheduler::Event* event = nullptr;
+    u64 timestamp; // of the next sample
   } channels[16];
 
+  /// Channels do not schedule events for their samples. Instead the samples are generated
+  /// in batches when the mixer runs and before a channel's registers are accessed.
+  void Update(uint chan_id);
+  void Mix(u64 timestamp);
+  void MixChannel(uint chan_id, int count, s32* left, s32* right);
+  void GenerateSamples(uint chan_id, u64 timestamp);
+
   void StepMixer(int cycles_late);
-  void StepChannel(uint chan_id, int cycles_late);
+  void StepChannel(uint chan_id);
+
+  u64 mixer_timestamp; // of the next output sample
+
+  /// Mixed samples on their way from the emulator thread to the audio thread.
+  common::SPSCRing<Frame, kRingBufferSize> buffer;
 
-  s16 buffer[2][kRingBufferSize];
-  int buffer_rd_pos;
-  int buffer_wr_pos;
-  int buffer_count;
-  std::mutex buffer_lock;
+  /// Only used by the audio thread.
+  Resampler resampler;
+  double average_fill = 0;
+  double input_position = 0;
+  double rate_correction = 0;
   Scheduler& scheduler;
   arm::MemoryBase* memory = nullptr;
   AudioDevice* audio_device = nullptr;
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "resampler.hpp"
+
+namespace Duality::Core {
+
+static constexpr double kPi = 3.14159265358979323846;
+
+void Resampler::Configure(uint input_rate, uint output_rate, Quality quality) {
+  this->input_rate = input_rate;
+  this->output_rate = output_rate;
+  this->quality = quality;
+
+  if (quality != Quality::Sinc) {
+    return;
+  }
+
+  // Cut off a little below the lower of both Nyquist frequencies.
+  auto cutoff = std::min(1.0, double(output_rate) / input_rate) * 0.95;
+
+  for (int phase = 0; phase <= kPhases; phase++) {
+    auto fraction = double(phase) / kPhases;
+    auto sum = 0.0;
+    double taps[kTaps];
+
+    for (int i = 0; i < kTaps; i++) {
+      // Distance of the input frame from the output position, within [-kTaps/2, +kTaps/2].
+      auto x = i - (kTaps / 2 - 1) - fraction;
+      auto t = x / (kTaps / 2);
+      auto sinc = x == 0 ? 1.0 : std::sin(kPi * cutoff * x) / (kPi * cutoff * x);
+      auto blackman = 0.42 + 0.5 * std::cos(kPi * t) + 0.08 * std::cos(2 * kPi * t);
+
+      taps[i] = sinc * blackman;
+      sum += taps[i];
+    }
+
+    // Normalize the gain, so that a constant input gives the same constant output.
+    for (int i = 0; i < kTaps; i++) {
+      coefficients[phase][i] = float(taps[i] / sum);
+    }
+  }
+}
+
+void Resampler::Process(int input_count, s16* output, int output_count) {
+  auto clamp = [](float sample) {
+    return s16(std::clamp(sample, -32768.0f, +32767.0f));
+  };
+
+  for (int i = 0; i < output_count; i++) {
+    // Position after the last frame of the previous block, in 32.32 fixed-point.
+    // The last output frame of the block lands on the last input frame.
+    auto position = (u64(i + 1) * u64(input_count) << 32) / u64(output_count);
+    auto index = int(position >> 32);
+    auto fraction = u32(position);
+
+    if (quality == Quality::Sinc) {
+      auto const& taps = coefficients[(u64(fraction) * kPhases + 0x80000000) >> 32];
+      auto const* input = &frames[index];
+      float left = 0;
+      float right = 0;
+
+      for (int j = 0; j < kTaps; j++) {
+        left  += input[j].left  * taps[j];
+        right += input[j].right * taps[j];
+      }
+
+      *output++ = clamp(left);
+      *output++ = clamp(right);
+    } else {
+      auto const& a = frames[kTaps - 1 + index];
+      auto const& b = frames[kTaps - 1 + std::min(index + 1, input_count)];
+      auto t = float(fraction) / 4294967296.0f;
+
+      *output++ = clamp(a.left  + (b.left  - a.left ) * t);
+      *output++ = clamp(a.right + (b.right - a.right) * t);
+    }
+  }
+
+  if (input_count != 0) {
+    std::copy(&frames[input_count], &frames[input_count + kTaps], &frames[0]);
+  }
+}
+
+} // namespace Duality::Core
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <util/integer.hpp>
+
+namespace Duality::Core {
+
+/// Converts a stereo stream to another sample rate, one block at a time.
+/// Process() turns exactly the given number of input frames into the requested number
+/// of output frames, so that the caller can adjust the ratio for every block.
+struct Resampler {
+  struct Frame {
+    s16 left = 0;
+    s16 right = 0;
+  };
+
+  enum class Quality {
+    /// Linear interpolation, cheap but muffles high frequencies.
+    Linear,
+    /// Polyphase windowed sinc filter, delays the output by kTaps / 2 input frames.
+    Sinc
+  };
+
+  /// Maximum number of input frames per call to Process().
+  static constexpr int kMaxInputFrames = 8192;
+
+  void Configure(uint input_rate, uint output_rate, Quality quality);
+
+  auto GetOutputRate() const -> uint { return output_rate; }
+
+  /// Where the input frames for the next call to Process() must be written to.
+  auto GetInputBuffer() -> Frame* { return &frames[kTaps]; }
+
+  /// Stretch or squeeze `input_count` frames from the input buffer into `output_count`
+  /// interleaved stereo frames. Without input the previous output is held.
+  void Process(int input_count, s16* output, int output_count);
+
+private:
+  static constexpr int kTaps = 16;
+  static constexpr int kPhases = 256;
+
+  uint input_rate = 0;
+  uint output_rate = 0;
+  Quality quality = Quality::Linear;
+
+  /// Filter taps for each fractional position between two input frames, in steps of 1 / kPhases.
+  float coefficients[kPhases + 1][kTaps];
+
+  /// The last kTaps input frames of the previous block, followed by the current block.
+  Frame frames[kTaps + kMaxInputFrames];
+};
+
+} // namespace Duality::Core
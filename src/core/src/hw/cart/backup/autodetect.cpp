@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <algorithm>
+#include <util/log.hpp>
+
+#include "autodetect.hpp"
+
+namespace Duality::Core {
+
+void BackupAutodetect::Reset() {
+  if (device) {
+    device->Reset();
+  }
+  spi = {};
+}
+
+void BackupAutodetect::Deselect() {
+  if (device) {
+    device->Deselect();
+    return;
+  }
+
+  auto length = spi.length;
+  spi.length = 0;
+
+  if (length == 0) {
+    return;
+  }
+
+  auto command = spi.transfer[0];
+
+  switch (command) {
+    case 0x06:
+      spi.enable_write = true;
+      return;
+    case 0x04:
+      spi.enable_write = false;
+      return;
+  }
+
+  auto type = DetectType(command, length);
+  if (type == Type::None) {
+    return;
+  }
+
+  LOG_INFO("Backup: detected {0} byte {1} from a {2} byte write transfer.",
+    GetSize(type), type >= Type::FLASH_256K ? "FLASH" : "EEPROM", length);
+
+  if (type == Type::FLASH_512K) {
+    LOG_WARN("Backup: the size of FLASH memory cannot be detected. If the game needs another size, "
+      "delete {0} and write the type (e.g. FLASH_1M or EEPROM_128K) into a .savtype file next to it.", save_path);
+  }
+
+  device = Create(type, save_path);
+
+  // Replay the transfer, so that the data ends up in the new device.
+  device->Transfer(0x06);
+  device->Deselect();
+  for (int i = 0; i < std::min(length, kMaxTransferLength); i++) {
+    device->Transfer(spi.transfer[i]);
+  }
+  device->Deselect();
+}
+
+auto BackupAutodetect::Transfer(u8 data) -> u8 {
+  if (device) {
+    return device->Transfer(data);
+  }
+
+  if (spi.length < kMaxTransferLength) {
+    spi.transfer[spi.length] = data;
+  }
+  spi.length++;
+
+  // Until the first write, the game sees an erased device that accepts write enable.
+  if (spi.length == 2 && spi.transfer[0] == 0x05) {
+    return spi.enable_write ? 2 : 0;
+  }
+  return 0xFF;
+}
+
+void BackupAutodetect::Flush() {
+  if (device) {
+    device->Flush();
+  }
+}
+
+void BackupAutodetect::LoadState(StateReader& state) {
+  if (device) {
+    device->LoadState(state);
+  } else {
+    state.Read(spi);
+  }
+}
+
+void BackupAutodetect::SaveState(StateWriter& state) {
+  if (device) {
+    device->SaveState(state);
+  } else {
+    state.Write(spi);
+  }
+}
+
+auto BackupAutodetect::DetectType(u8 command, int length) -> Type {
+  // FLASH-only commands.
+  if (command == 0xDB || command == 0xD8) {
+    return Type::FLASH_512K;
+  }
+
+  if (command != 0x02 && command != 0x0A) {
+    return Type::None;
+  }
+
+  // Command byte, address bytes and at most one page of data.
+  if (length <= 1 + 1 + 16) {
+    return Type::EEPROM_512B;
+  }
+  if (command == 0x02) {
+    if (length <= 1 + 2 + 32) {
+      return Type::EEPROM_8K;
+    }
+    if (length <= 1 + 2 + 128) {
+      return Type::EEPROM_64K;
+    }
+  }
+
+  // 128 KiB EEPROM and FLASH look identical, FLASH is far more common.
+  return Type::FLASH_512K;
+}
+
+} // namespace Duality::Core
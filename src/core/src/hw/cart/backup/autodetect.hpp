@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "backup.hpp"
+
+namespace Duality::Core {
+
+/// Stands in for the backup device of a game that does not have a save file yet.
+/// The type is derived from the length of the game's first write transfer,
+/// which is command + address + one full page of data on every known cartridge.
+/// Afterwards all transfers are forwarded to the detected device.
+///
+/// Some types cannot be told apart this way, see DetectType(). For those games the
+/// type can be set in a .savtype file next to the save file, see Cartridge::LoadBackup().
+struct BackupAutodetect final : Backup {
+  BackupAutodetect(std::string const& save_path) : save_path(save_path) {}
+
+  auto GetType() const -> Type override {
+    return device ? device->GetType() : Type::Autodetect;
+  }
+
+  void Reset() override;
+  void Deselect() override;
+  auto Transfer(u8 data) -> u8 override;
+  void Flush() override;
+  void LoadState(StateReader& state) override;
+  void SaveState(StateWriter& state) override;
+
+private:
+  /// Longest write transfer that is recorded: command, three address bytes and a 256 byte page.
+  static constexpr int kMaxTransferLength = 4 + 256;
+
+  /// Cases that are guessed rather than detected:
+  /// - all FLASH chips share their commands and page size, so FLASH is always assumed to be 512 KiB.
+  /// - 128 KiB EEPROM also uses three address bytes and 256 byte pages, it is detected as FLASH.
+  /// - FRAM has no pages, its writes look like EEPROM writes of about the same length.
+  static auto DetectType(u8 command, int length) -> Type;
+
+  std::string save_path;
+  std::unique_ptr<Backup> device;
+
+  struct {
+    bool enable_write;
+    int length;
+    u8 transfer[kMaxTransferLength];
+  } spi {};
+};
+
+} // namespace Duality::Core
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <util/log.hpp>
+#include <utility>
+
+#include "autodetect.hpp"
+#include "eeprom.hpp"
+#include "flash.hpp"
+
+namespace Duality::Core {
+
+auto Backup::Create(Type type, std::string const& save_path) -> std::unique_ptr<Backup> {
+  switch (type) {
+    case Type::None:
+      return {};
+    case Type::Autodetect:
+      return std::make_unique<BackupAutodetect>(save_path);
+    case Type::EEPROM_512B:
+    case Type::EEPROM_8K:
+    case Type::EEPROM_64K:
+    case Type::EEPROM_128K:
+    case Type::FRAM_32K:
+      return std::make_unique<EEPROM>(save_path, type);
+    case Type::FLASH_256K:
+    case Type::FLASH_512K:
+    case Type::FLASH_1M:
+      return std::make_unique<FLASH>(save_path, type);
+  }
+
+  UNREACHABLE;
+}
+
+auto Backup::GetTypeFromSize(size_t size) -> Type {
+  switch (size) {
+    case 512:         return Type::EEPROM_512B;
+    case 8 * 1024:    return Type::EEPROM_8K;
+    case 32 * 1024:   return Type::FRAM_32K;
+    case 64 * 1024:   return Type::EEPROM_64K;
+    case 128 * 1024:  return Type::EEPROM_128K;
+    case 256 * 1024:  return Type::FLASH_256K;
+    case 512 * 1024:  return Type::FLASH_512K;
+    case 1024 * 1024: return Type::FLASH_1M;
+  }
+
+  return Type::None;
+}
+
+auto Backup::GetTypeFromName(std::string const& name) -> Type {
+  static const std::pair<const char*, Type> kNames[] {
+    { "None",        Type::None        },
+    { "EEPROM_512B", Type::EEPROM_512B },
+    { "EEPROM_8K",   Type::EEPROM_8K   },
+    { "EEPROM_64K",  Type::EEPROM_64K  },
+    { "EEPROM_128K", Type::EEPROM_128K },
+    { "FRAM_32K",    Type::FRAM_32K    },
+    { "FLASH_256K",  Type::FLASH_256K  },
+    { "FLASH_512K",  Type::FLASH_512K  },
+    { "FLASH_1M",    Type::FLASH_1M    }
+  };
+
+  for (auto const& [type_name, type] : kNames) {
+    if (name == type_name) {
+      return type;
+    }
+  }
+
+  return Type::Autodetect;
+}
+
+auto Backup::GetSize(Type type) -> size_t {
+  switch (type) {
+    case Type::None:
+    case Type::Autodetect:
+      return 0;
+    case Type::EEPROM_512B: return 512;
+    case Type::EEPROM_8K:   return 8 * 1024;
+    case Type::EEPROM_64K:  return 64 * 1024;
+    case Type::EEPROM_128K: return 128 * 1024;
+    case Type::FRAM_32K:    return 32 * 1024;
+    case Type::FLASH_256K:  return 256 * 1024;
+    case Type::FLASH_512K:  return 512 * 1024;
+    case Type::FLASH_1M:    return 1024 * 1024;
+  }
+
+  UNREACHABLE;
+}
+
+} // namespace Duality::Core
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <util/integer.hpp>
+
+#include "save_state.hpp"
+
+namespace Duality::Core {
+
+/// Cartridge SPI backup memory, which holds the game's save data.
+struct Backup {
+  /// NOTE: the values are part of the save state format, only append new ones.
+  enum class Type : u8 {
+    None,
+    Autodetect,
+    EEPROM_512B,
+    EEPROM_8K,
+    EEPROM_64K,
+    EEPROM_128K,
+    FRAM_32K,
+    FLASH_256K,
+    FLASH_512K,
+    FLASH_1M
+  };
+
+  virtual ~Backup() = default;
+
+  /// Create a backup device that stores its data in the given file.
+  static auto Create(Type type, std::string const& save_path) -> std::unique_ptr<Backup>;
+
+  /// Guess the backup type from the size of an existing save file.
+  static auto GetTypeFromSize(size_t size) -> Type;
+
+  /// Parse a type name as written in the enum, e.g. "FLASH_1M". Returns Autodetect for unknown names.
+  static auto GetTypeFromName(std::string const& name) -> Type;
+  static auto GetSize(Type type) -> size_t;
+
+  virtual auto GetType() const -> Type = 0;
+  virtual void Reset() = 0;
+  virtual void Deselect() = 0;
+  virtual auto Transfer(u8 data) -> u8 = 0;
+
+  /// Block until all modified save data has been written to disk.
+  virtual void Flush() = 0;
+
+  /// NOTE: the save data itself is not part of the save state,
+  /// so that loading a state never rolls back the game's save file.
+  virtual void LoadState(StateReader& state) = 0;
+  virtual void SaveState(StateWriter& state) = 0;
+};
+
+} // namespace Duality::Core
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <string.h>
+#include <util/log.hpp>
+
+#include "backup_file.hpp"
+
+namespace Duality::Core {
+
+BackupFile::BackupFile(std::string const& path, size_t size, u8 fill_value)
+    : path(path)
+    , size(size) {
+  std::error_code error;
+  size_t old_size = 0;
+  if (std::filesystem::exists(path, error)) {
+    old_size = std::filesystem::file_size(path, error);
+    if (error) old_size = 0;
+  }
+
+  if (file.OpenWritable(path, size)) {
+    data = file.MutableData();
+    thread = std::thread{[this]() { ThreadMain(); }};
+  } else {
+    LOG_ERROR("Backup: failed to open {0}, save data will not be kept.", path);
+    fallback_buffer.resize(size);
+    data = fallback_buffer.data();
+    old_size = 0;
+  }
+
+  // Erased FLASH and fresh EEPROM read back as all ones.
+  if (old_size < size) {
+    memset(data + old_size, fill_value, size - old_size);
+    MarkDirty(u32(old_size), u32(size - old_size));
+  }
+}
+
+BackupFile::~BackupFile() {
+  if (thread.joinable()) {
+    {
+      std::lock_guard guard{lock};
+      quit = true;
+    }
+    cv.notify_one();
+    thread.join();
+  }
+  Flush();
+}
+
+void BackupFile::MarkDirty(u32 offset, u32 length) {
+  if (!file.IsWritable()) {
+    return;
+  }
+
+  {
+    std::lock_guard guard{lock};
+    dirty_lo = std::min(dirty_lo, size_t(offset));
+    dirty_hi = std::max(dirty_hi, std::min(size_t(offset) + length, size));
+  }
+  cv.notify_one();
+}
+
+void BackupFile::Flush() {
+  size_t lo;
+  size_t hi;
+
+  {
+    std::lock_guard guard{lock};
+    lo = dirty_lo;
+    hi = dirty_hi;
+    dirty_lo = ~size_t(0);
+    dirty_hi = 0;
+  }
+
+  if (lo < hi && !file.Flush(lo, hi - lo)) {
+    LOG_ERROR("Backup: failed to write save data to {0}", path);
+  }
+}
+
+void BackupFile::ThreadMain() {
+  std::unique_lock guard{lock};
+
+  while (true) {
+    cv.wait(guard, [this]() { return quit || dirty_lo < dirty_hi; });
+    if (quit) {
+      break;
+    }
+
+    // Games usually write their save data in many small transfers,
+    // wait for them to finish before touching the disk.
+    cv.wait_for(guard, kFlushDelay, [this]() { return quit; });
+
+    guard.unlock();
+    Flush();
+    guard.lock();
+  }
+}
+
+} // namespace Duality::Core
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <util/integer.hpp>
+#include <util/mapped_file.hpp>
+#include <vector>
+
+namespace Duality::Core {
+
+/// Save data of a backup device, stored in a memory-mapped save file
+/// (or an in-memory copy of it, where the host cannot map files).
+/// The emulation thread writes straight into the data and reports the
+/// modified range, which a background thread then writes back to disk.
+struct BackupFile {
+  /// Opens (or creates) the save file. Newly added bytes are filled with fill_value.
+  BackupFile(std::string const& path, size_t size, u8 fill_value = 0xFF);
+ ~BackupFile();
+
+  auto Data() -> u8* { return data; }
+  auto Size() const -> size_t { return size; }
+
+  /// Schedule a modified range for writing back to disk.
+  void MarkDirty(u32 offset, u32 length);
+
+  /// Block until all modified data has been written to disk.
+  void Flush();
+
+private:
+  /// Delay before writing back, so that consecutive writes end up in a single flush.
+  static constexpr auto kFlushDelay = std::chrono::milliseconds(200);
+
+  void ThreadMain();
+
+  common::MappedFile file;
+  std::vector<u8> fallback_buffer;
+  std::string path;
+  u8* data = nullptr;
+  size_t size = 0;
+
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable cv;
+  size_t dirty_lo = ~size_t(0);
+  size_t dirty_hi = 0;
+  bool quit = false;
+};
+
+} // namespace Duality::Core
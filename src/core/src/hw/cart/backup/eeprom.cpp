@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <algorithm>
+#include <util/log.hpp>
+
+#include "eeprom.hpp"
+
+namespace Duality::Core {
+
+EEPROM::EEPROM(std::string const& save_path, Type type)
+    : type(type)
+    , file(save_path, GetSize(type)) {
+  mask = u32(file.Size() - 1);
+
+  switch (type) {
+    case Type::EEPROM_512B:
+      address_bytes = 1;
+      page_mask = 15;
+      break;
+    case Type::EEPROM_8K:
+      address_bytes = 2;
+      page_mask = 31;
+      break;
+    case Type::EEPROM_64K:
+      address_bytes = 2;
+      page_mask = 127;
+      break;
+    case Type::EEPROM_128K:
+      address_bytes = 3;
+      page_mask = 255;
+      break;
+    case Type::FRAM_32K:
+      // FRAM has no pages, writes simply continue at the next address.
+      address_bytes = 2;
+      page_mask = mask;
+      break;
+    default:
+      ASSERT(false, "Backup: EEPROM: unsupported type: {0}", static_cast<int>(type));
+  }
+
+  Reset();
+}
+
+void EEPROM::Reset() {
+  spi.state = State::ReceiveCommand;
+  spi.command = Command::ReadStatus;
+  spi.address = 0;
+  spi.address_bytes_left = 0;
+  spi.status = 0;
+  spi.dirty_lo = ~0U;
+  spi.dirty_hi = 0;
+}
+
+void EEPROM::LoadState(StateReader& state) {
+  state.Read(spi);
+
+  state.Check(spi.state <= State::Ignore, "EEPROM: bad state in save state.");
+  state.Check(spi.state != State::ReadAddress || (spi.address_bytes_left >= 1 && spi.address_bytes_left <= address_bytes),
+    "EEPROM: bad address byte count in save state.");
+  state.Check(spi.dirty_lo >= spi.dirty_hi || spi.dirty_hi <= file.Size(), "EEPROM: bad dirty range in save state.");
+  spi.address &= mask;
+}
+
+void EEPROM::SaveState(StateWriter& state) {
+  state.Write(spi);
+}
+
+void EEPROM::Deselect() {
+  if (spi.state == State::WriteData) {
+    if (spi.dirty_lo < spi.dirty_hi) {
+      file.MarkDirty(spi.dirty_lo, spi.dirty_hi - spi.dirty_lo);
+    }
+    spi.dirty_lo = ~0U;
+    spi.dirty_hi = 0;
+    spi.status &= ~kStatusWriteEnable;
+  }
+  spi.state = State::ReceiveCommand;
+}
+
+auto EEPROM::Transfer(u8 data) -> u8 {
+  switch (spi.state) {
+    case State::ReceiveCommand:
+      ParseCommand(data);
+      break;
+    case State::ReadAddress:
+      spi.address = (spi.address << 8) | data;
+      if (--spi.address_bytes_left == 0) {
+        spi.address &= mask;
+        spi.state = spi.command == Command::ReadData ? State::ReadData : State::WriteData;
+      }
+      break;
+    case State::ReadData: {
+      auto value = file.Data()[spi.address];
+      spi.address = (spi.address + 1) & mask;
+      return value;
+    }
+    case State::WriteData:
+      file.Data()[spi.address] = data;
+      spi.dirty_lo = std::min(spi.dirty_lo, spi.address);
+      spi.dirty_hi = std::max(spi.dirty_hi, spi.address + 1);
+      // Writes wrap around within the current page.
+      spi.address = (spi.address & ~page_mask) | ((spi.address + 1) & page_mask);
+      break;
+    case State::ReadStatus:
+      return spi.status;
+    case State::WriteStatus:
+      spi.status = (spi.status & ~kStatusBlockProtect) | (data & kStatusBlockProtect);
+      spi.state = State::Ignore;
+      break;
+    case State::Ignore:
+      break;
+  }
+
+  return 0xFF;
+}
+
+void EEPROM::ParseCommand(u8 command) {
+  // The 512 byte EEPROM encodes the ninth address bit in the command.
+  if (type == Type::EEPROM_512B && ((command & 0xF7) == 0x02 || (command & 0xF7) == 0x03)) {
+    spi.address = (command & 8) ? 1 : 0;
+    command &= 0xF7;
+  } else {
+    spi.address = 0;
+  }
+
+  spi.command = static_cast<Command>(command);
+  spi.address_bytes_left = address_bytes;
+
+  switch (spi.command) {
+    case Command::ReadData:
+      spi.state = State::ReadAddress;
+      break;
+    case Command::WriteData:
+      if (spi.status & kStatusWriteEnable) {
+        spi.state = State::ReadAddress;
+      } else {
+        LOG_WARN("Backup: EEPROM: attempted to write while write-protected.");
+        spi.state = State::Ignore;
+      }
+      break;
+    case Command::ReadStatus:
+      spi.state = State::ReadStatus;
+      break;
+    case Command::WriteStatus:
+      spi.state = (spi.status & kStatusWriteEnable) ? State::WriteStatus : State::Ignore;
+      break;
+    case Command::WriteEnable:
+      spi.status |= kStatusWriteEnable;
+      spi.state = State::Ignore;
+      break;
+    case Command::WriteDisable:
+      spi.status &= ~kStatusWriteEnable;
+      spi.state = State::Ignore;
+      break;
+    default:
+      LOG_WARN("Backup: EEPROM: unhandled command: 0x{0:02X}", command);
+      spi.state = State::Ignore;
+      break;
+  }
+}
+
+} // namespace Duality::Core
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include "backup.hpp"
+#include "backup_file.hpp"
+
+namespace Duality::Core {
+
+/// SPI EEPROM and FRAM backup memory.
+/// http://problemkaputt.de/gbatek.htm#dscartbackupspiflasheeprom
+struct EEPROM final : Backup {
+  EEPROM(std::string const& save_path, Type type);
+
+  auto GetType() const -> Type override { return type; }
+  void Reset() override;
+  void Deselect() override;
+  auto Transfer(u8 data) -> u8 override;
+  void Flush() override { file.Flush(); }
+  void LoadState(StateReader& state) override;
+  void SaveState(StateWriter& state) override;
+
+private:
+  enum class Command : u8 {
+    WriteStatus  = 0x01, // WRSR
+    WriteData    = 0x02, // WR (0x0A: WRHI on 512 byte EEPROM)
+    ReadData     = 0x03, // RD (0x0B: RDHI on 512 byte EEPROM)
+    WriteDisable = 0x04, // WRDI
+    ReadStatus   = 0x05, // RDSR
+    WriteEnable  = 0x06  // WREN
+  };
+
+  enum class State : u8 {
+    ReceiveCommand,
+    ReadAddress,
+    ReadData,
+    WriteData,
+    ReadStatus,
+    WriteStatus,
+    Ignore
+  };
+
+  static constexpr u8 kStatusWriteEnable = 2;
+  static constexpr u8 kStatusBlockProtect = 0x0C;
+
+  void ParseCommand(u8 command);
+
+  Type type;
+  BackupFile file;
+  u32 mask;
+  u32 page_mask;
+  int address_bytes;
+
+  struct {
+    State state;
+    Command command;
+    u32 address;
+    int address_bytes_left;
+    u8 status;
+
+    /// Range written by the current command, written back once it ends.
+    u32 dirty_lo;
+    u32 dirty_hi;
+  } spi;
+};
+
+} // namespace Duality::Core
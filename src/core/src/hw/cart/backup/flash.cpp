@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <algorithm>
+#include <string.h>
+#include <util/log.hpp>
+
+#include "flash.hpp"
+
+namespace Duality::Core {
+
+FLASH::FLASH(std::string const& save_path, Type type)
+    : type(type)
+    , file(save_path, GetSize(type)) {
+  mask = u32(file.Size() - 1);
+  Reset();
+}
+
+void FLASH::Reset() {
+  spi.state = State::ReceiveCommand;
+  spi.command = Command::ReadStatus;
+  spi.address = 0;
+  spi.jedec_index = 0;
+  spi.enable_write = false;
+  spi.dirty_lo = ~0U;
+  spi.dirty_hi = 0;
+}
+
+void FLASH::LoadState(StateReader& state) {
+  state.Read(spi);
+
+  bool reads_address = spi.state >= State::ReadAddress0 && spi.state <= State::ReadAddress2;
+
+  state.Check(spi.state <= State::Ignore, "FLASH: bad state in save state.");
+  state.Check(!reads_address || IsAddressCommand(spi.command), "FLASH: bad command in save state.");
+  state.Check(spi.jedec_index >= 0 && spi.jedec_index <= 3, "FLASH: bad JEDEC index in save state.");
+  state.Check(spi.dirty_lo >= spi.dirty_hi || spi.dirty_hi <= file.Size(), "FLASH: bad dirty range in save state.");
+  spi.address &= mask;
+}
+
+void FLASH::SaveState(StateWriter& state) {
+  state.Write(spi);
+}
+
+void FLASH::Deselect() {
+  if (spi.state == State::WriteData) {
+    if (spi.dirty_lo < spi.dirty_hi) {
+      file.MarkDirty(spi.dirty_lo, spi.dirty_hi - spi.dirty_lo);
+    }
+    spi.dirty_lo = ~0U;
+    spi.dirty_hi = 0;
+    spi.enable_write = false;
+  }
+  spi.state = State::ReceiveCommand;
+}
+
+auto FLASH::Transfer(u8 data) -> u8 {
+  switch (spi.state) {
+    case State::ReceiveCommand:
+      ParseCommand(data);
+      break;
+    case State::ReadAddress0:
+      spi.address = data << 16;
+      spi.state = State::ReadAddress1;
+      break;
+    case State::ReadAddress1:
+      spi.address |= data << 8;
+      spi.state = State::ReadAddress2;
+      break;
+    case State::ReadAddress2:
+      spi.address = (spi.address | data) & mask;
+      switch (spi.command) {
+        case Command::ReadData:
+          spi.state = State::ReadData;
+          break;
+        case Command::ReadDataFast:
+          spi.state = State::ReadDummy;
+          break;
+        case Command::PageWrite:
+        case Command::PageProgram:
+          spi.state = State::WriteData;
+          break;
+        case Command::PageErase:
+          Erase(spi.address & ~(kPageSize - 1), kPageSize);
+          break;
+        case Command::SectorErase:
+          Erase(spi.address & ~(kSectorSize - 1), kSectorSize);
+          break;
+        default:
+          UNREACHABLE;
+      }
+      break;
+    case State::ReadDummy:
+      spi.state = State::ReadData;
+      break;
+    case State::ReadData: {
+      auto value = file.Data()[spi.address];
+      spi.address = (spi.address + 1) & mask;
+      return value;
+    }
+    case State::WriteData: {
+      auto& byte = file.Data()[spi.address];
+      if (spi.command == Command::PageWrite) {
+        byte = data;
+      } else {
+        // Programming can only clear bits, erasing sets them.
+        byte &= data;
+      }
+      spi.dirty_lo = std::min(spi.dirty_lo, spi.address);
+      spi.dirty_hi = std::max(spi.dirty_hi, spi.address + 1);
+      // Writes wrap around within the current page.
+      spi.address = (spi.address & ~(kPageSize - 1)) | ((spi.address + 1) & (kPageSize - 1));
+      break;
+    }
+    case State::ReadStatus:
+      // TODO: write/program/erase in progress
+      return spi.enable_write ? 2 : 0;
+    case State::ReadJEDEC: {
+      static constexpr u8 kJEDEC_256K[3] { 0x20, 0x40, 0x12 };
+      static constexpr u8 kJEDEC_512K[3] { 0x20, 0x40, 0x13 };
+      static constexpr u8 kJEDEC_1M[3]   { 0x20, 0x40, 0x14 };
+
+      if (spi.jedec_index == 3) {
+        return 0xFF;
+      }
+      switch (type) {
+        case Type::FLASH_256K: return kJEDEC_256K[spi.jedec_index++];
+        case Type::FLASH_512K: return kJEDEC_512K[spi.jedec_index++];
+        default: return kJEDEC_1M[spi.jedec_index++];
+      }
+    }
+    case State::ReadIRStatus:
+      return 0xAA;
+    case State::Ignore:
+      break;
+  }
+
+  return 0xFF;
+}
+
+auto FLASH::IsAddressCommand(Command command) -> bool {
+  switch (command) {
+    case Command::ReadData:
+    case Command::ReadDataFast:
+    case Command::PageWrite:
+    case Command::PageProgram:
+    case Command::PageErase:
+    case Command::SectorErase:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void FLASH::ParseCommand(u8 command) {
+  spi.command = static_cast<Command>(command);
+
+  switch (spi.command) {
+    case Command::ReadData:
+    case Command::ReadDataFast:
+      spi.state = State::ReadAddress0;
+      break;
+    case Command::PageWrite:
+    case Command::PageProgram:
+    case Command::PageErase:
+    case Command::SectorErase:
+      if (spi.enable_write) {
+        spi.state = State::ReadAddress0;
+      } else {
+        LOG_WARN("Backup: FLASH: attempted to write while write-protected.");
+        spi.state = State::Ignore;
+      }
+      break;
+    case Command::ReadStatus:
+      spi.state = State::ReadStatus;
+      break;
+    case Command::ReadJEDEC:
+      spi.jedec_index = 0;
+      spi.state = State::ReadJEDEC;
+      break;
+    case Command::WriteEnable:
+      spi.enable_write = true;
+      spi.state = State::Ignore;
+      break;
+    case Command::WriteDisable:
+      spi.enable_write = false;
+      spi.state = State::Ignore;
+      break;
+    case Command::DeepPowerDown:
+    case Command::ReleaseDeepPowerDown:
+      spi.state = State::Ignore;
+      break;
+    case Command::IRPassthrough:
+      // Keep waiting for the actual FLASH command.
+      break;
+    case Command::IRReadStatus:
+      spi.state = State::ReadIRStatus;
+      break;
+    default:
+      LOG_WARN("Backup: FLASH: unhandled command: 0x{0:02X}", command);
+      spi.state = State::Ignore;
+      break;
+  }
+}
+
+void FLASH::Erase(u32 address, u32 size) {
+  size = std::min(size, mask + 1);
+  memset(file.Data() + address, 0xFF, size);
+  file.MarkDirty(address, size);
+  spi.enable_write = false;
+  spi.state = State::Ignore;
+}
+
+} // namespace Duality::Core
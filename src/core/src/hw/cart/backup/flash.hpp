@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include "backup.hpp"
+#include "backup_file.hpp"
+
+namespace Duality::Core {
+
+/// SPI FLASH backup memory.
+/// http://problemkaputt.de/gbatek.htm#dscartbackupspiflasheeprom
+struct FLASH final : Backup {
+  FLASH(std::string const& save_path, Type type);
+
+  auto GetType() const -> Type override { return type; }
+  void Reset() override;
+  void Deselect() override;
+  auto Transfer(u8 data) -> u8 override;
+  void Flush() override { file.Flush(); }
+  void LoadState(StateReader& state) override;
+  void SaveState(StateWriter& state) override;
+
+private:
+  enum class Command : u8 {
+    WriteEnable   = 0x06, // WREN
+    WriteDisable  = 0x04, // WRDI
+    ReadJEDEC     = 0x9F, // RDID
+    ReadStatus    = 0x05, // RDSR
+    ReadData      = 0x03, // READ
+    ReadDataFast  = 0x0B, // FAST
+    PageWrite     = 0x0A, // PW
+    PageProgram   = 0x02, // PP
+    PageErase     = 0xDB, // PE
+    SectorErase   = 0xD8, // SE
+    DeepPowerDown = 0xB9, // DP
+    ReleaseDeepPowerDown = 0xAB, // RDP
+
+    /// Infrared cartridges (e.g. Pokémon HG/SS) put an IR controller in front of the FLASH.
+    /// Command 0x00 passes the following bytes through to the FLASH.
+    IRPassthrough = 0x00,
+    IRReadStatus  = 0x08
+  };
+
+  enum class State : u8 {
+    ReceiveCommand,
+    ReadAddress0,
+    ReadAddress1,
+    ReadAddress2,
+    ReadDummy,
+    ReadData,
+    WriteData,
+    ReadStatus,
+    ReadJEDEC,
+    ReadIRStatus,
+    Ignore
+  };
+
+  static constexpr u32 kPageSize = 256;
+  static constexpr u32 kSectorSize = 0x10000;
+
+  static auto IsAddressCommand(Command command) -> bool;
+
+  void ParseCommand(u8 command);
+  void Erase(u32 address, u32 size);
+
+  Type type;
+  BackupFile file;
+  u32 mask;
+
+  struct {
+    State state;
+    Command command;
+    u32 address;
+    int jedec_index;
+    bool enable_write;
+
+    /// Range written by the current command, written back once it ends.
+    u32 dirty_lo;
+    u32 dirty_hi;
+  } spi;
+};
+
+} // namespace Duality::Core
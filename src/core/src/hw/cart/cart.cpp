@@ -3,6 +3,9 @@
  */
 
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string.h>
 #include <util/log.hpp>
 
 #include "cart.hpp"
@@ -10,37 +13,148 @@
 namespace Duality::Core {
 
 void Cartridge::Reset() {
-  if (file.is_open())
-    file.close();
+  rom.Close();
   loaded = false;
   // FIXME: properly reset AUXSPICNT and ROMCTRL.
   //auxspicnt = {};
   //romctrl = {};
   cardcmd = {};
   spidata = 0;
+  if (backup) {
+    backup->Reset();
+  }
 }
 
-void Cartridge::Load(std::string const& path) {
-  u32 file_size;
-
-  if (file.is_open())
-    file.close();
-  loaded = false;
+auto Cartridge::Load(std::string const& path) -> bool {
+  loaded = rom.Open(path);
+  if (!loaded) {
+    LOG_ERROR("Cartridge: failed to load ROM: {0}", path);
+    return false;
+  }
 
-  file.open(path, std::ios::in | std::ios::binary);
-  ASSERT(file.good(), "Cartridge: failed to load ROM: {0}", path);
-  loaded = true;
-  file.seekg(0, std::ios::end);
-  file_size = file.tellg();
-  file.seekg(0);
+  if (!rom.IsMapped()) {
+    LOG_WARN("Cartridge: cannot memory-map ROM, loaded it into memory instead.");
+  }
 
   // Generate power-of-two mask for ROM mirroring.
   for (int i = 0; i < 32; i++) {
-    if (file_size <= (1 << i)) {
-      file_mask = (1 << i) - 1;
+    if (rom.Size() <= (1ULL << i)) {
+      rom_mask = (1ULL << i) - 1;
       break;
     }
   }
+
+  LoadBackup(std::filesystem::path{path}.replace_extension(".sav").string());
+  return true;
+}
+
+void Cartridge::LoadBackup(std::string const& save_path) {
+  // Make sure that the previous save file has been written back, before it may be reopened.
+  backup.reset();
+
+  // The backup type can be set in a file next to the save file (e.g. game.savtype containing "FLASH_1M"),
+  // for games where it cannot be detected from the first write, see BackupAutodetect.
+  auto type = Backup::Type::Autodetect;
+  auto type_path = std::filesystem::path{save_path}.replace_extension(".savtype");
+
+  std::error_code error;
+  if (std::filesystem::exists(type_path, error)) {
+    std::string name;
+    std::ifstream{type_path} >> name;
+    type = Backup::GetTypeFromName(name);
+    if (type == Backup::Type::Autodetect) {
+      LOG_ERROR("Cartridge: unknown backup type '{0}' in {1}, it will be ignored.", name, type_path.string());
+    }
+  }
+
+  if (std::filesystem::exists(save_path, error)) {
+    auto size = std::filesystem::file_size(save_path, error);
+    auto size_type = error ? Backup::Type::None : Backup::GetTypeFromSize(size);
+    if (size_type == Backup::Type::None) {
+      LOG_ERROR("Cartridge: save file {0} has unexpected size, it will not be used.", save_path);
+      return;
+    }
+    // Never resize an existing save file, that could destroy save data.
+    if (type != Backup::Type::Autodetect && type != size_type) {
+      LOG_ERROR("Cartridge: save file {0} does not match the type in {1}, it will not be used.", save_path, type_path.string());
+      return;
+    }
+    type = size_type;
+  }
+
+  backup = Backup::Create(type, save_path);
+}
+
+void Cartridge::FlushBackup() {
+  if (backup) {
+    backup->Flush();
+  }
+}
+
+void Cartridge::ReadROMBlock(u32 address, void* dst, size_t size) {
+  size_t available = 0;
+
+  if (address < rom.Size()) {
+    available = std::min(size, rom.Size() - address);
+    memcpy(dst, rom.Data() + address, available);
+  }
+
+  // Reads past the end of the ROM return open bus.
+  memset((u8*)dst + available, 0xFF, size - available);
+}
+
+void Cartridge::LoadState(StateReader& state) {
+  state.Read(auxspicnt.baudrate);
+  state.Read(auxspicnt.chipselect_hold);
+  state.Read(auxspicnt.busy);
+  state.Read(auxspicnt.select_spi);
+  state.Read(auxspicnt.enable_ready_irq);
+  state.Read(auxspicnt.enable_slot);
+  state.Read(romctrl.data_block_size);
+  state.Read(cardcmd.buffer);
+  state.Read(transfer);
+  state.Read(spidata);
+
+  state.Check(romctrl.data_block_size >= 0 && romctrl.data_block_size <= 7, "Cartridge: bad data block size in save state.");
+  state.Check(transfer.count >= 0 && transfer.count <= 0x40 << 6 && transfer.index >= 0 && transfer.index <= transfer.count,
+    "Cartridge: bad transfer position in save state.");
+  state.Check(transfer.data_count >= 0 && transfer.data_count <= (int)std::size(transfer.data), "Cartridge: bad transfer length in save state.");
+
+  // The backup state depends on the backup type, which may differ if the
+  // save file was created after the save state.
+  auto type = state.Read<Backup::Type>();
+  auto size = state.Read<u32>();
+  if (type == (backup ? backup->GetType() : Backup::Type::None)) {
+    if (backup) backup->LoadState(state);
+  } else {
+    LOG_WARN("Cartridge: save state was created with a different backup type, skipping backup state.");
+    state.Skip(size);
+    if (backup) {
+      backup->Reset();
+    }
+  }
+}
+
+void Cartridge::SaveState(StateWriter& state) {
+  state.Write(auxspicnt.baudrate);
+  state.Write(auxspicnt.chipselect_hold);
+  state.Write(auxspicnt.busy);
+  state.Write(auxspicnt.select_spi);
+  state.Write(auxspicnt.enable_ready_irq);
+  state.Write(auxspicnt.enable_slot);
+  state.Write(romctrl.data_block_size);
+  state.Write(cardcmd.buffer);
+  state.Write(transfer);
+  state.Write(spidata);
+
+  backup_state.clear();
+  if (backup) {
+    StateWriter backup_writer{backup_state};
+    backup->SaveState(backup_writer);
+  }
+  state.Write(backup ? backup->GetType() : Backup::Type::None);
+  state.Write(u32(backup_state.size()));
+  state.Write(backup_state.data(), backup_state.size());
 }
 
 void Cartridge::OnCommandStart() {
@@ -65,7 +179,7 @@ void Cartridge::OnCommandStart() {
       address |= cardcmd.buffer[3] <<  8;
       address |= cardcmd.buffer[4] <<  0;
       
-      address &= file_mask;
+      address &= rom_mask;
 
       if (address <= 0x7FFF) {
         address = 0x8000 + (address & 0x1FF);
@@ -81,16 +195,14 @@ void Cartridge::OnCommandStart() {
       u32 sector_a = address >> 12;
       u32 sector_b = (address + byte_len - 1) >> 12;
 
-      file.seekg(address);
-
+      // Reads wrap around at 4 KiB sector boundaries.
       if (sector_a != sector_b) {
         u32 size_a = 0x1000 - (address & 0xFFF);
         u32 size_b = byte_len - size_a;
-        file.read((char*)transfer.data, size_a);
-        file.seekg(address & ~0xFFF);
-        file.read((char*)transfer.data + size_a, size_b);
+        ReadROMBlock(address, transfer.data, size_a);
+        ReadROMBlock(address & ~0xFFF, (u8*)transfer.data + size_a, size_b);
       } else {
-        file.read((char*)transfer.data, byte_len);
+        ReadROMBlock(address, transfer.data, byte_len);
       }
       break;
     }
@@ -122,10 +234,15 @@ auto Cartridge::ReadSPI() -> u8 {
 }
 
 void Cartridge::WriteSPI(u8 value) {
-  spidata = backup.Transfer(value);
-  
+  if (!backup) {
+    spidata = 0xFF;
+    return;
+  }
+
+  spidata = backup->Transfer(value);
+
   if (!auxspicnt.chipselect_hold)
-    backup.Deselect();
+    backup->Deselect();
 }
 
 auto Cartridge::ReadROM() -> u32 {
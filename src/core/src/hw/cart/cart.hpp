@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include <memory>
 #include <util/integer.hpp>
-#include <fstream>
+#include <util/mapped_file.hpp>
 #include <string>
+#include <vector>
 
-#include "backup.hpp"
+#include "backup/backup.hpp"
 #include "hw/dma/dma7.hpp"
 #include "hw/dma/dma9.hpp"
 #include "hw/irq/irq.hpp"
@@ -25,11 +27,22 @@ struct Cartridge {
   }
 
   void Reset();
-  void Load(std::string const& path);
+
+  /// Map the ROM and open the save file next to it. Returns false if the ROM cannot be opened.
+  auto Load(std::string const& path) -> bool;
+
+  /// The mapped ROM, e.g. to copy the boot binaries from it.
+  auto GetROM() const -> common::MappedFile const& { return rom; }
+
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   auto ReadSPI() -> u8;
   void WriteSPI(u8 value);
   auto ReadROM() -> u32;
 
+  /// Block until modified save data has been written to disk.
+  void FlushBackup();
+
   struct AUXSPICNT {
     AUXSPICNT(Cartridge& cart) : cart(cart) {}
 
@@ -77,11 +90,13 @@ struct Cartridge {
 
 private:
   void OnCommandStart();
+  void LoadBackup(std::string const& save_path);
+
+  void ReadROMBlock(u32 address, void* dst, size_t size);
 
-  // TODO: abstract the cartridge file away.
   bool loaded = false;
-  std::fstream file;
-  u32 file_mask = 0;
+  common::MappedFile rom;
+  u32 rom_mask = 0;
 
   struct {
     /// Current index into the data buffer (before modulo data_count)
@@ -104,7 +119,10 @@ private:
   DMA9& dma9;
   IRQ& irq7;
   IRQ& irq9;
-  Backup backup;
+
+  /// Backup memory, which is stored in a .sav file next to the ROM.
+  std::unique_ptr<Backup> backup;
+  std::vector<u8> backup_state;
 };
 
 } // namespace Duality::Core
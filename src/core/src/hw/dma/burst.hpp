@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <buildconfig.hpp>
+#include <string.h>
+#include <util/integer.hpp>
+#include <util/punning.hpp>
+
+#include "arm/memory.hpp"
+
+namespace Duality::Core {
+
+namespace detail {
+
+/// Number of elements that can be transferred before the address leaves its current page.
+template<typename T>
+auto ElementsInPage(u32 address, int offset) -> u32 {
+  using arm::MemoryBase;
+
+  if (offset > 0) {
+    return ((MemoryBase::kPageMask + 1) - (address & MemoryBase::kPageMask)) / sizeof(T);
+  }
+  if (offset < 0) {
+    return (address & MemoryBase::kPageMask) / sizeof(T) + 1;
+  }
+  return ~0U;
+}
+
+} // namespace Duality::Core::detail
+
+/// Run a DMA transfer of `length` elements of type T.
+/// The transfer is split at page boundaries. Spans where both addresses resolve
+/// to host memory through the pagetables are moved with a single memcpy/memset,
+/// only MMIO and other unmapped regions go through the per-element slow path.
+/// src, dst and length are updated to reflect the state after the transfer.
+template<typename T>
+void BurstTransfer(arm::MemoryBase& memory, u32& src, u32& dst, u32& length, int src_offset, int dst_offset) {
+  using arm::MemoryBase;
+  using Bus = MemoryBase::Bus;
+
+  while (length != 0) {
+    auto count = std::min(length, detail::ElementsInPage<T>(src, src_offset));
+    count = std::min(count, detail::ElementsInPage<T>(dst, dst_offset));
+
+    u8* src_page = nullptr;
+    u8* dst_page = nullptr;
+
+    // Decrementing transfers are rare enough to not deserve a fast path.
+    if (gEnableFastMemory && memory.pagetable != nullptr && src_offset >= 0 && dst_offset >= 0) {
+      src_page = (*memory.pagetable)[src >> MemoryBase::kPageShift];
+      dst_page = (*memory.write_pagetable)[dst >> MemoryBase::kPageShift];
+    }
+
+    if (src_page == nullptr || dst_page == nullptr) {
+      for (u32 i = 0; i < count; i++) {
+        memory.FastWrite<T, Bus::System>(dst, memory.FastRead<T, Bus::System>(src));
+        src += src_offset;
+        dst += dst_offset;
+      }
+      length -= count;
+      continue;
+    }
+
+    auto src_host = src_page + (src & MemoryBase::kPageMask & ~(sizeof(T) - 1));
+    auto dst_host = dst_page + (dst & MemoryBase::kPageMask & ~(sizeof(T) - 1));
+    auto size = count * sizeof(T);
+
+    if (dst_offset == 0) {
+      // Only the last element remains visible at a fixed destination.
+      write<T>(dst_host, 0, read<T>(src_host, src_offset == 0 ? 0 : size - sizeof(T)));
+    } else if (src_offset == 0) {
+      auto value = read<T>(src_host, 0);
+      if (value == T(u8(value) * T(T(~0) / 0xFF))) {
+        memset(dst_host, u8(value), size);
+      } else {
+        for (u32 i = 0; i < count; i++) write<T>(dst_host, i * sizeof(T), value);
+      }
+    } else if (dst_host > src_host && dst_host < src_host + size) {
+      // The element-wise forward copy replicates the overlapping data, memmove would not.
+      for (u32 i = 0; i < count; i++) write<T>(dst_host, i * sizeof(T), read<T>(src_host, i * sizeof(T)));
+    } else {
+      memmove(dst_host, src_host, size);
+    }
+
+    *(*memory.dirtytable)[dst >> MemoryBase::kPageShift] = 1;
+
+    src += src_offset * count;
+    dst += dst_offset * count;
+    length -= count;
+  }
+}
+
+} // namespace Duality::Core
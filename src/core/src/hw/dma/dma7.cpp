@@ -2,9 +2,13 @@
  * Copyright (C) 2020 fleroviux
  */
 
+#include <algorithm>
 #include <util/log.hpp>
 
+#include "burst.hpp"
 #include "dma7.hpp"
+#include "profiler.hpp"
+#include "tracer.hpp"
 
 namespace Duality::Core {
 
@@ -24,6 +28,26 @@ void DMA7::Reset() {
   for (uint i = 0; i < 4; i++) {
     channels[i] = {i};
   }
+  event = nullptr;
+}
+
+void DMA7::LoadState(StateReader& state) {
+  state.Read(channels);
+
+  for (uint i = 0; i < 4; i++) {
+    auto const& channel = channels[i];
+
+    state.Check(channel.id == i, "DMA7: bad channel ID in save state.");
+    state.Check(channel.dst_mode <= Channel::Reload && channel.src_mode <= Channel::Reload, "DMA7: bad address mode in save state.");
+    state.Check(channel.size <= Channel::Word && channel.time <= Time::Special, "DMA7: bad channel control in save state.");
+    state.Check(channel.length <= g_dma_len_mask[i] && channel.latch.length <= u32(g_dma_len_mask[i]) + 1, "DMA7: bad length in save state.");
+  }
+
+  event = scheduler.Find(Scheduler::EventClass::ARM7_DMA);
+}
+
+void DMA7::SaveState(StateWriter& state) {
+  state.Write(channels);
 }
 
 auto DMA7::Read(uint chan_id, uint offset) -> u8 {
@@ -113,7 +137,7 @@ void DMA7::Write(uint chan_id, uint offset, u8 value) {
           channel.latch.length = g_dma_len_mask[channel.id] + 1;
         }
         if (channel.time == Time::Immediate) {
-          RunChannel(channel);
+          Trigger(channel);
         }
         // Diagnostics, get rid of it once emulation is more stable...
         switch (channel.time) {
@@ -125,6 +149,9 @@ void DMA7::Write(uint chan_id, uint offset, u8 value) {
             ASSERT(false, "DMA7: unhandled start time: {0}", channel.time);
             break;
         }
+      } else if (!channel.enable) {
+        channel.active = false;
+        channel.pending = false;
       }
       break;
     }
@@ -134,38 +161,84 @@ void DMA7::Write(uint chan_id, uint offset, u8 value) {
 void DMA7::Request(Time time) {
   for (auto& channel : channels) {
     if (channel.enable && channel.time == time)
-      RunChannel(channel);
+      Trigger(channel);
+  }
+}
+
+void DMA7::Trigger(Channel& channel) {
+  // A request that arrives during the transfer (e.g. Slot1 being
+  // read by the transfer itself) starts the next block afterwards.
+  if (channel.active) {
+    channel.pending = true;
+    return;
+  }
+
+  channel.active = true;
+
+  LOG_TRACE("DMA7: transfer src=0x{0:08X} dst=0x{1:08X} length=0x{2:08X} size={3}",
+    channel.latch.src, channel.latch.dst, channel.latch.length, channel.size);
+
+  if (event == nullptr) {
+    event = scheduler.Add(kStartupDelay, Scheduler::EventClass::ARM7_DMA);
+  }
+
+  // The ARM7 is stalled as soon as the DMA owns the bus.
+  if (core != nullptr) {
+    core->Stop();
   }
 }
 
-void DMA7::RunChannel(Channel& channel) {
+void DMA7::OnStep(int cycles_late) {
+  Profiler::Scope scope{Profiler::Section::DMA7};
+
+  event = nullptr;
+
+  // Lower channel numbers have priority.
+  Channel* channel = nullptr;
+  for (auto& candidate : channels) {
+    if (candidate.active) {
+      channel = &candidate;
+      break;
+    }
+  }
+
+  // Nothing left to transfer, the ARM7 can continue.
+  if (channel == nullptr) {
+    return;
+  }
+
+  Tracer::Scope trace_scope{Tracer::Track::ARM7, "DMA7", "length", channel->latch.length};
+
   // FIXME: what happens if source control is set to reload?
   static constexpr int dma_modify[2][4] = {
     { 2, -2, 0, 2 },
     { 4, -4, 0, 4 }
   };
 
-  int dst_offset = dma_modify[channel.size][channel.dst_mode];
-  int src_offset = dma_modify[channel.size][channel.src_mode];
+  int dst_offset = dma_modify[channel->size][channel->dst_mode];
+  int src_offset = dma_modify[channel->size][channel->src_mode];
 
-  LOG_INFO("DMA7: transfer src=0x{0:08X} dst=0x{1:08X} length=0x{2:08X} size={3}",
-    channel.latch.src, channel.latch.dst, channel.latch.length, channel.size);
-
-  // TODO: read and write full 64-bit words at once as long as possible?
-  if (channel.size == Channel::Size::Word) {
-    while (channel.latch.length-- != 0) {
-      memory->FastWrite<u32, Bus::System>(channel.latch.dst, memory->FastRead<u32, Bus::System>(channel.latch.src));
-      channel.latch.dst += dst_offset;
-      channel.latch.src += src_offset;
-    }
+  auto count = std::min(kChunkSize, channel->latch.length);
+  auto length = count;
+  if (channel->size == Channel::Size::Word) {
+    BurstTransfer<u32>(*memory, channel->latch.src, channel->latch.dst, length, src_offset, dst_offset);
   } else {
-    while (channel.latch.length-- != 0) {
-      memory->FastWrite<u16, Bus::System>(channel.latch.dst, memory->FastRead<u16, Bus::System>(channel.latch.src));
-      channel.latch.dst += dst_offset;
-      channel.latch.src += src_offset;
-    }
+    BurstTransfer<u16>(*memory, channel->latch.src, channel->latch.dst, length, src_offset, dst_offset);
+  }
+  channel->latch.length -= count;
+
+  if (channel->latch.length == 0) {
+    OnBlockDone(*channel);
   }
 
+  // Rough approximation of the bus timing: one cycle per 16 bits.
+  auto cycles = count * (channel->size == Channel::Size::Word ? 2 : 1);
+  event = scheduler.Add(std::max(1, int(cycles) - cycles_late), Scheduler::EventClass::ARM7_DMA);
+}
+
+void DMA7::OnBlockDone(Channel& channel) {
+  channel.active = false;
+
   if (channel.repeat && channel.time != Time::Immediate) {
     channel.latch.length = channel.length;
     if (channel.latch.length == 0) {
@@ -174,10 +247,13 @@ void DMA7::RunChannel(Channel& channel) {
     if (channel.dst_mode == Channel::AddressMode::Reload) {
       channel.latch.dst = channel.dst & (channel.size == Channel::Size::Word ? ~3 : ~1);
     }
+    channel.active = channel.pending;
   } else {
     channel.enable = false;
   }
 
+  channel.pending = false;
+
   if (channel.interrupt) {
     switch (channel.id) {
       case 0: irq.Raise(IRQ::Source::DMA0); break;
@@ -6,8 +6,11 @@
 
 #include <util/integer.hpp>
 
+#include "arm/arm.hpp"
 #include "arm/memory.hpp"
 #include "hw/irq/irq.hpp"
+#include "save_state.hpp"
+#include "scheduler.hpp"
 
 namespace Duality::Core {
 
@@ -21,18 +24,25 @@ struct DMA7 {
 
   using Bus = arm::MemoryBase::Bus;
 
-  DMA7(IRQ& irq) : irq(irq) {
+  DMA7(Scheduler& scheduler, IRQ& irq) : scheduler(scheduler), irq(irq) {
+    scheduler.Register(Scheduler::EventClass::ARM7_DMA, this, &DMA7::OnStep);
     Reset();
   }
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   auto Read (uint chan_id, uint offset) -> u8;
   void Write(uint chan_id, uint offset, u8 value);
   void Request(Time time);
 
+  /// Whether a transfer currently owns the bus, which stalls the ARM7.
+  bool IsRunning() const { return event != nullptr; }
+
   // TODO: get rid of this ugly hack that only exists
   // because we can't pass "memory" to the constructor at the moment.
   void SetMemory(arm::MemoryBase* memory) { this->memory = memory; }
+  void SetCore(arm::ARM& core) { this->core = &core; }
 
 private:
   enum Registers {
@@ -50,6 +60,12 @@ private:
     bool repeat = false;
     bool interrupt = false;
 
+    /// The channel has been triggered and has not finished its block yet.
+    bool active = false;
+
+    /// The channel was triggered again while it was active.
+    bool pending = false;
+
     u32 length = 0;
     u32 dst = 0;
     u32 src = 0;
@@ -75,9 +91,20 @@ private:
     } latch;
   } channels[4] { 0, 1, 2, 3 };
 
-  void RunChannel(Channel& channel);
+  /// Number of elements transferred before other channels and hardware events get a chance to run.
+  static constexpr u32 kChunkSize = 256;
+
+  /// Cycles between a channel being triggered and its first access.
+  static constexpr int kStartupDelay = 2;
+
+  void Trigger(Channel& channel);
+  void OnStep(int cycles_late);
+  void OnBlockDone(Channel& channel);
 
   arm::MemoryBase* memory;
+  arm::ARM* core = nullptr;
+  Scheduler& scheduler;
+  Scheduler::Event* event = nullptr;
   IRQ& irq;
 };
 
@@ -2,10 +2,14 @@
  * Copyright (C) 2020 fleroviux
  */
 
+#include <algorithm>
 #include <util/log.hpp>
 #include <string.h>
 
+#include "burst.hpp"
 #include "dma9.hpp"
+#include "profiler.hpp"
+#include "tracer.hpp"
 
 namespace Duality::Core {
 
@@ -17,6 +21,31 @@ void DMA9::Reset() {
   }
 
   gxfifo_half_empty = false;
+  event = nullptr;
+}
+
+void DMA9::LoadState(StateReader& state) {
+  state.Read(channels);
+  state.Read(filldata);
+  state.Read(gxfifo_half_empty);
+
+  for (uint i = 0; i < 4; i++) {
+    auto const& channel = channels[i];
+
+    state.Check(channel.id == i, "DMA9: bad channel ID in save state.");
+    state.Check(channel.dst_mode <= Channel::Reload && channel.src_mode <= Channel::Reload, "DMA9: bad address mode in save state.");
+    state.Check(channel.size <= Channel::Word && channel.time <= Time::GxFIFO, "DMA9: bad channel control in save state.");
+    state.Check(channel.length <= 0x1FFFFF && channel.latch.length <= 0x200000, "DMA9: bad length in save state.");
+    state.Check(channel.gxfifo_burst_left <= kGXFIFOBurstSize, "DMA9: bad GXFIFO burst in save state.");
+  }
+
+  event = scheduler.Find(Scheduler::EventClass::ARM9_DMA);
+}
+
+void DMA9::SaveState(StateWriter& state) {
+  state.Write(channels);
+  state.Write(filldata);
+  state.Write(gxfifo_half_empty);
 }
 
 auto DMA9::Read(uint chan_id, uint offset) -> u8 {
@@ -110,7 +139,7 @@ void DMA9::Write(uint chan_id, uint offset, u8 value) {
           channel.latch.length = channel.length;
         }
         if (channel.time == Time::Immediate || (channel.time == Time::GxFIFO && gxfifo_half_empty)) {
-          RunChannel(channel);
+          Trigger(channel);
         }
         // Diagnostics, get rid of it once emulation is more stable...
         switch (channel.time) {
@@ -124,6 +153,9 @@ void DMA9::Write(uint chan_id, uint offset, u8 value) {
             ASSERT(false, "DMA9: unhandled start time: {0}", channel.time);
             break;
         }
+      } else if (!channel.enable) {
+        channel.active = false;
+        channel.pending = false;
       }
       break;
     }
@@ -145,46 +177,97 @@ void DMA9::WriteFill(uint offset, u8 value) {
 void DMA9::Request(Time time) {
   for (auto& channel : channels) {
     if (channel.enable && channel.time == time)
-      RunChannel(channel);
+      Trigger(channel);
+  }
+}
+
+void DMA9::Trigger(Channel& channel) {
+  // A request that arrives during the transfer (e.g. GXFIFO or Slot1
+  // being fed by the transfer itself) starts the next block afterwards.
+  if (channel.active) {
+    channel.pending = true;
+    return;
+  }
+
+  channel.active = true;
+  channel.gxfifo_burst_left = kGXFIFOBurstSize;
+
+  LOG_TRACE("DMA9: transfer src=0x{0:08X} dst=0x{1:08X} length=0x{2:08X} size={3} time={4}",
+    channel.latch.src, channel.latch.dst, channel.latch.length, channel.size, channel.time);
+
+  if (event == nullptr) {
+    event = scheduler.Add(kStartupDelay, Scheduler::EventClass::ARM9_DMA);
+  }
+
+  // The ARM9 is stalled as soon as the DMA owns the bus.
+  if (core != nullptr) {
+    core->Stop();
   }
 }
 
-void DMA9::RunChannel(Channel& channel) {
+void DMA9::OnStep(int cycles_late) {
+  Profiler::Scope scope{Profiler::Section::DMA9};
+
+  event = nullptr;
+
+  // Lower channel numbers have priority.
+  Channel* channel = nullptr;
+  for (auto& candidate : channels) {
+    if (candidate.active) {
+      channel = &candidate;
+      break;
+    }
+  }
+
+  // Nothing left to transfer, the ARM9 can continue.
+  if (channel == nullptr) {
+    return;
+  }
+
+  Tracer::Scope trace_scope{Tracer::Track::ARM9, "DMA9", "length", channel->latch.length};
+
   // FIXME: what happens if source control is set to reload?
   static constexpr int dma_modify[2][4] = {
     { 2, -2, 0, 2 },
     { 4, -4, 0, 4 }
   };
 
-  int dst_offset = dma_modify[channel.size][channel.dst_mode];
-  int src_offset = dma_modify[channel.size][channel.src_mode];
+  int dst_offset = dma_modify[channel->size][channel->dst_mode];
+  int src_offset = dma_modify[channel->size][channel->src_mode];
 
-  LOG_INFO("DMA9: transfer src=0x{0:08X} dst=0x{1:08X} length=0x{2:08X} size={3} time={4}",
-    channel.latch.src, channel.latch.dst, channel.latch.length, channel.size, channel.time);
-
-  // TODO: this an absolutely atrocious hack.
-  // Rework DMA so we don't need iffy workarounds like this.
-  if (channel.running && channel.time == Time::GxFIFO) {
-    return;
+  auto count = std::min(kChunkSize, channel->latch.length);
+  if (channel->time == Time::GxFIFO) {
+    count = std::min(count, channel->gxfifo_burst_left);
   }
 
-  channel.running = true;
-
-  // TODO: read and write full 64-bit words at once as long as possible?
-  if (channel.size == Channel::Size::Word) {
-    while (channel.latch.length-- != 0) {
-      memory->FastWrite<u32, Bus::System>(channel.latch.dst, memory->FastRead<u32, Bus::System>(channel.latch.src));
-      channel.latch.dst += dst_offset;
-      channel.latch.src += src_offset;
-    }
+  auto length = count;
+  if (channel->size == Channel::Size::Word) {
+    BurstTransfer<u32>(*memory, channel->latch.src, channel->latch.dst, length, src_offset, dst_offset);
   } else {
-    while (channel.latch.length-- != 0) {
-      memory->FastWrite<u16, Bus::System>(channel.latch.dst, memory->FastRead<u16, Bus::System>(channel.latch.src));
-      channel.latch.dst += dst_offset;
-      channel.latch.src += src_offset;
+    BurstTransfer<u16>(*memory, channel->latch.src, channel->latch.dst, length, src_offset, dst_offset);
+  }
+  channel->latch.length -= count;
+
+  if (channel->latch.length == 0) {
+    OnBlockDone(*channel);
+  } else if (channel->time == Time::GxFIFO) {
+    channel->gxfifo_burst_left -= count;
+    if (channel->gxfifo_burst_left == 0) {
+      // Wait until the geometry engine has drained the FIFO below half again.
+      channel->active = channel->pending || gxfifo_half_empty;
+      channel->pending = false;
+      channel->gxfifo_burst_left = kGXFIFOBurstSize;
     }
   }
 
+  // Rough approximation of the bus timing: one cycle per 16 bits.
+  auto cycles = count * (channel->size == Channel::Size::Word ? 2 : 1);
+  event = scheduler.Add(std::max(1, int(cycles) - cycles_late), Scheduler::EventClass::ARM9_DMA);
+}
+
+void DMA9::OnBlockDone(Channel& channel) {
+  channel.active = false;
+
   if (channel.repeat && channel.time != Time::Immediate) {
     if (channel.length == 0) {
       channel.latch.length = 0x200000;
@@ -194,10 +277,16 @@ void DMA9::RunChannel(Channel& channel) {
     if (channel.dst_mode == Channel::AddressMode::Reload) {
       channel.latch.dst = channel.dst & (channel.size == Channel::Size::Word ? ~3 : ~1);
     }
+    if (channel.pending || (channel.time == Time::GxFIFO && gxfifo_half_empty)) {
+      channel.active = true;
+      channel.gxfifo_burst_left = kGXFIFOBurstSize;
+    }
   } else {
     channel.enable = false;
   }
 
+  channel.pending = false;
+
   if (channel.interrupt) {
     switch (channel.id) {
       case 0: irq.Raise(IRQ::Source::DMA0); break;
@@ -206,8 +295,6 @@ void DMA9::RunChannel(Channel& channel) {
       case 3: irq.Raise(IRQ::Source::DMA3); break;
     }
   }
-
-  channel.running = false;
 }
 
 } // namespace Duality::Core
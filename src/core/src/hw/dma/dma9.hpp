@@ -6,8 +6,11 @@
 
 #include <util/integer.hpp>
 
+#include "arm/arm.hpp"
 #include "arm/memory.hpp"
 #include "hw/irq/irq.hpp"
+#include "save_state.hpp"
+#include "scheduler.hpp"
 
 namespace Duality::Core {
 
@@ -25,11 +28,14 @@ struct DMA9 {
 
   using Bus = arm::MemoryBase::Bus;
 
-  DMA9(IRQ& irq) : irq(irq) {
+  DMA9(Scheduler& scheduler, IRQ& irq) : scheduler(scheduler), irq(irq) {
+    scheduler.Register(Scheduler::EventClass::ARM9_DMA, this, &DMA9::OnStep);
     Reset();
   }
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   auto Read (uint chan_id, uint offset) -> u8;
   void Write(uint chan_id, uint offset, u8 value);
   auto ReadFill (uint offset) -> u8;
@@ -37,9 +43,13 @@ struct DMA9 {
   void Request(Time time);
   void SetGXFIFOHalfEmpty(bool value) { gxfifo_half_empty = value; }
 
+  /// Whether a transfer currently owns the bus, which stalls the ARM9.
+  bool IsRunning() const { return event != nullptr; }
+
   // TODO: get rid of this ugly hack that only exists
   // because we can't pass "memory" to the constructor at the moment.
   void SetMemory(arm::MemoryBase* memory) { this->memory = memory; }
+  void SetCore(arm::ARM& core) { this->core = &core; }
 
 private:
   enum Registers {
@@ -56,7 +66,15 @@ private:
     bool enable = false;
     bool repeat = false;
     bool interrupt = false;
-    bool running = false;
+
+    /// The channel has been triggered and has not finished its block yet.
+    bool active = false;
+
+    /// The channel was triggered again while it was active.
+    bool pending = false;
+
+    /// Words left in the current GXFIFO burst.
+    u32 gxfifo_burst_left = 0;
 
     u32 length = 0;
     u32 dst = 0;
@@ -83,10 +101,24 @@ private:
     } latch;
   } channels[4] { 0, 1, 2, 3 };
 
-  void RunChannel(Channel& channel);
+  /// Number of elements transferred before other channels and hardware events get a chance to run.
+  static constexpr u32 kChunkSize = 256;
+
+  /// The geometry engine is fed 112 words each time the GXFIFO becomes less than half full.
+  static constexpr u32 kGXFIFOBurstSize = 112;
+
+  /// Cycles between a channel being triggered and its first access.
+  static constexpr int kStartupDelay = 2;
+
+  void Trigger(Channel& channel);
+  void OnStep(int cycles_late);
+  void OnBlockDone(Channel& channel);
 
   u8 filldata[16];
   arm::MemoryBase* memory;
+  arm::ARM* core = nullptr;
+  Scheduler& scheduler;
+  Scheduler::Event* event = nullptr;
   IRQ& irq;
   bool gxfifo_half_empty;
 };
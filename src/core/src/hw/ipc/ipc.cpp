@@ -21,6 +21,17 @@ void IPC::Reset() {
   fifo[static_cast<uint>(Client::ARM9)] = {};
 }
 
+void IPC::LoadState(StateReader& state) {
+  state.Read(sync);
+  state.Read(fifo);
+  state.Check(fifo[0].send.IsValid() && fifo[1].send.IsValid(), "IPC: bad FIFO in save state.");
+}
+
+void IPC::SaveState(StateWriter& state) {
+  state.Write(sync);
+  state.Write(fifo);
+}
+
 void IPC::RequestIRQ(Client client, IRQ::Source reason) {
   irq[static_cast<uint>(client)]->Raise(reason);
 }
@@ -124,13 +135,13 @@ void IPC::IPCFIFOSEND::WriteWord(Client client, u32 value) {
   auto& fifo_rx = ipc.fifo[static_cast<uint>(GetRemote(client))];
 
   if (!fifo_tx.enable) {
-    LOG_ERROR("IPC[{0}]: attempted write FIFO but FIFOs are disabled.", client);
+    LOG_ERROR("IPC[{0}]: attempted write FIFO but FIFOs are disabled.", static_cast<uint>(client));
     return;
   }
   
   if (fifo_tx.send.IsFull()) {
     fifo_tx.error = true;
-    LOG_ERROR("IPC[{0}]: attempted to write to already full FIFO.", client);
+    LOG_ERROR("IPC[{0}]: attempted to write to already full FIFO.", static_cast<uint>(client));
     return;
   }
 
@@ -163,14 +174,14 @@ auto IPC::IPCFIFORECV::ReadWord(Client client) -> u32 {
   auto& fifo_rx = ipc.fifo[static_cast<uint>(GetRemote(client))];
 
   if (!fifo_tx.enable) {
-    LOG_ERROR("IPC[{0}]: attempted to read FIFO but FIFOs are disabled.", client);
+    LOG_ERROR("IPC[{0}]: attempted to read FIFO but FIFOs are disabled.", static_cast<uint>(client));
     // TODO: figure out if this read should update the latch.
     return fifo_rx.send.Peek();
   }
 
   if (fifo_rx.send.IsEmpty()) {
     fifo_tx.error = true;
-    LOG_ERROR("IPC[{0}]: attempted to read empty FIFO.", client);
+    LOG_ERROR("IPC[{0}]: attempted to read empty FIFO.", static_cast<uint>(client));
     return fifo_tx.latch;
   }
 
@@ -8,6 +8,7 @@
 #include <util/integer.hpp>
 
 #include "hw/irq/irq.hpp"
+#include "save_state.hpp"
 
 namespace Duality::Core {
 
@@ -22,6 +23,8 @@ struct IPC {
   IPC(IRQ& irq7, IRQ& irq9);
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
 
   struct IPCSYNC {
     IPCSYNC(IPC& ipc) : ipc(ipc) {}
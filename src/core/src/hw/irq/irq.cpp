@@ -8,7 +8,7 @@
 
 namespace Duality::Core {
 
-IRQ::IRQ() {
+IRQ::IRQ(Tracer::Track track) : track(track) {
   Reset();
 }
 
@@ -23,7 +23,26 @@ void IRQ::Reset() {
   UpdateIRQLine();
 }
 
+void IRQ::LoadState(StateReader& state) {
+  state.Read(ime.enabled);
+  state.Read(ie.value);
+  state.Read(_if.value);
+  UpdateIRQLine();
+}
+
+void IRQ::SaveState(StateWriter& state) {
+  state.Write(ime.enabled);
+  state.Write(ie.value);
+  state.Write(_if.value);
+}
+
 void IRQ::Raise(Source source) {
+  if constexpr (gEnableTracing) {
+    if (auto tracer = Tracer::Current(); tracer != nullptr) {
+      tracer->Instant(track, "IRQ", "source", static_cast<u32>(source));
+    }
+  }
+
   _if.value |= static_cast<u32>(source);
   UpdateIRQLine();
 }
@@ -7,6 +7,8 @@
 #include <util/integer.hpp>
 
 #include "arm/arm.hpp"
+#include "save_state.hpp"
+#include "tracer.hpp"
 
 namespace Duality::Core {
 
@@ -32,9 +34,11 @@ struct IRQ {
     SPI = 1 << 23
   };
 
-  IRQ();
+  IRQ(Tracer::Track track);
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   void SetCore(arm::ARM& core) { this->core = &core; UpdateIRQLine(); }
   void Raise(Source source);
   bool IsEnabled();
@@ -80,6 +84,7 @@ private:
   void UpdateIRQLine();
 
   arm::ARM* core = nullptr;
+  Tracer::Track track;
 };
 
 } // namespace Duality::Core
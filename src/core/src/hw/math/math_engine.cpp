@@ -15,6 +15,31 @@ void MathEngine::Reset() {
   sqrt_result = {};
 }
 
+void MathEngine::LoadState(StateReader& state) {
+  state.Read(divcnt.mode);
+  state.Read(divcnt.error_divide_by_zero);
+  state.Read(div_numer.value);
+  state.Read(div_denom.value);
+  state.Read(div_result.value);
+  state.Read(div_remain.value);
+  state.Read(sqrtcnt.mode_64bit);
+  state.Read(sqrt_result.value);
+  state.Read(sqrt_param.value);
+  state.Check(divcnt.mode >= DivisionMode::S32_S32 && divcnt.mode <= DivisionMode::Reserved, "MathEngine: bad division mode in save state.");
+}
+
+void MathEngine::SaveState(StateWriter& state) {
+  state.Write(divcnt.mode);
+  state.Write(divcnt.error_divide_by_zero);
+  state.Write(div_numer.value);
+  state.Write(div_denom.value);
+  state.Write(div_result.value);
+  state.Write(div_remain.value);
+  state.Write(sqrtcnt.mode_64bit);
+  state.Write(sqrt_result.value);
+  state.Write(sqrt_param.value);
+}
+
 auto MathEngine::DIVCNT::ReadByte(uint offset) -> u8 {
   switch (offset) {
     case 0:
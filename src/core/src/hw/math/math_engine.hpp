@@ -6,6 +6,8 @@
 
 #include <util/integer.hpp>
 
+#include "save_state.hpp"
+
 namespace Duality::Core {
 
 /// Hardware accelerated 64-bit division and square root engine.
@@ -20,6 +22,8 @@ struct MathEngine {
   MathEngine() { Reset(); }
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
 
   struct DIVCNT {
     DIVCNT(MathEngine& math_engine) : math_engine(math_engine) {}
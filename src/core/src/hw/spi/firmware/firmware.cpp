@@ -2,6 +2,8 @@
  * Copyright (C) fleroviux
  */
 
+#include <algorithm>
+#include <fstream>
 #include <util/log.hpp>
 
 #include "firmware.hpp"
@@ -9,23 +11,80 @@
 namespace Duality::Core {
 
 void Firmware::Reset() {
-  if (file.is_open()) {
-    file.close();
-  }
-  file.open("firmware.bin", std::ios::in | std::ios::out | std::ios::binary);
-  ASSERT(file.good(), "Firmware: failed to open firmware.bin");
+  Sync();
+  Load();
   state = State::Deselected;
   address = 0;
   enable_write = false;
 }
 
+void Firmware::LoadState(StateReader& state) {
+  state.Read(this->state);
+  state.Read(command);
+  state.Read(address);
+  state.Read(enable_write);
+
+  bool reads_address = this->state >= State::ReadAddress0 && this->state <= State::ReadAddress2;
+  bool writes_data = this->state == State::WriteData;
+
+  state.Check(this->state >= State::ReceiveCommand && this->state <= State::Ignore, "Firmware: bad state in save state.");
+  state.Check(!reads_address || command == Command::ReadData || IsWriteCommand(command), "Firmware: bad command in save state.");
+  state.Check(!writes_data || command == Command::PageWrite || command == Command::PageProgram, "Firmware: bad command in save state.");
+  address &= mask;
+}
+
+void Firmware::SaveState(StateWriter& state) {
+  state.Write(this->state);
+  state.Write(command);
+  state.Write(address);
+  state.Write(enable_write);
+}
+
+void Firmware::Load() {
+  std::ifstream file{path, std::ios::in | std::ios::binary};
+  ASSERT(file.good(), "Firmware: failed to open {0}", path);
+
+  file.seekg(0, std::ios::end);
+  size = u32(file.tellg());
+  file.seekg(0);
+
+  // Round the flash size up to a power-of-two, so that addresses can simply wrap around.
+  mask = 0;
+  while (mask + 1 < size) {
+    mask = (mask << 1) | 1;
+  }
+
+  data.resize(mask + 1, 0xFF);
+  file.read((char*)data.data(), size);
+  ASSERT(file.good(), "Firmware: failed to read {0} bytes from {1}", size, path);
+  dirty = false;
+}
+
+void Firmware::Sync() {
+  if (!dirty) {
+    return;
+  }
+
+  std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+  if (!file.good()) {
+    LOG_ERROR("Firmware: failed to open {0} for writing", path);
+    return;
+  }
+  // The buffer may be larger than the file, see Load().
+  file.write((char*)data.data(), size);
+  dirty = false;
+}
+
 void Firmware::Select() {
-  LOG_INFO("SPI: FIRM: command start");
+  LOG_TRACE("SPI: FIRM: command start");
   state = State::ReceiveCommand;
 }
 
 void Firmware::Deselect() {
-  LOG_INFO("SPI: FIRM: deselected!");
+  LOG_TRACE("SPI: FIRM: deselected!");
+  if (state == State::WriteData) {
+    enable_write = false;
+  }
   state = State::Deselected;
 }
 
@@ -44,33 +103,76 @@ auto Firmware::Transfer(u8 data) -> u8 {
       break;
     case State::ReadAddress2:
       address |= data;
-      LOG_INFO("SPI: FIRM: read address completed, address = 0x{0:06X}", address);
-      if (command == Command::ReadData) {
-        state = State::ReadData;
-      } else {
-        ASSERT(false, "SPI: FIRM: no possible state transition from ReadAddress2");
+      LOG_TRACE("SPI: FIRM: read address completed, address = 0x{0:06X}", address);
+      switch (command) {
+        case Command::ReadData:
+          state = State::ReadData;
+          break;
+        case Command::PageWrite:
+        case Command::PageProgram:
+          state = State::WriteData;
+          break;
+        case Command::PageErase: {
+          auto page = (address & mask) & ~(kPageSize - 1);
+          std::fill_n(&this->data[page], kPageSize, 0xFF);
+          dirty = true;
+          enable_write = false;
+          state = State::Ignore;
+          break;
+        }
+        case Command::SectorErase: {
+          auto sector = (address & mask) & ~(kSectorSize - 1);
+          std::fill_n(&this->data[sector], std::min<u32>(kSectorSize, mask + 1), 0xFF);
+          dirty = true;
+          enable_write = false;
+          state = State::Ignore;
+          break;
+        }
+        default:
+          ASSERT(false, "SPI: FIRM: no possible state transition from ReadAddress2");
       }
       break;
     case State::ReadData:
-      // TODO: this is not a very efficient implementation.
-      // TODO: make sure the address is valid, possibly force firmware size and use wraparound?
-      file.seekg(address++);
-      file.read((char*)&data, 1);
-      LOG_INFO("SPI: FIRM: read 0x{0:02X} at address 0x{1:06X}", data, address - 1);
-      ASSERT(file.good(), "SPI: FIRM: firmware byte read went rougue");
-      return data;
+      return this->data[address++ & mask];
+    case State::WriteData: {
+      auto& byte = this->data[address & mask];
+      if (command == Command::PageWrite) {
+        byte = data;
+      } else {
+        // Programming can only clear bits, erasing sets them.
+        byte &= data;
+      }
+      // Writes wrap around within the current page.
+      address = (address & ~(kPageSize - 1)) | ((address + 1) & (kPageSize - 1));
+      dirty = true;
+      return 0;
+    }
     case State::ReadStatus:
       // TODO: write/program/erase in progress
       return (enable_write ? 2 : 0);
+    case State::Ignore:
+      return 0;
     case State::Deselected:
       ASSERT(false, "SPI: FIRM: attempted to access deselected device.");
     default:
-      ASSERT(false, "SPI: FIRM: unhandled state: {0}", state);
+      ASSERT(false, "SPI: FIRM: unhandled state: {0}", static_cast<int>(state));
   }
 
   return 0;
 }
 
+auto Firmware::IsWriteCommand(Command command) -> bool {
+  switch (command) {
+    case Command::PageWrite:
+    case Command::PageProgram:
+    case Command::PageErase:
+    case Command::SectorErase:
+      return true;
+    default:
+      return false;
+  }
+}
+
 void Firmware::ParseCommand(u8 command) {
   this->command = static_cast<Command>(command);
 
@@ -78,12 +180,26 @@ void Firmware::ParseCommand(u8 command) {
     case Command::ReadData:
       state = State::ReadAddress0;
       break;
+    case Command::PageWrite:
+    case Command::PageProgram:
+    case Command::PageErase:
+    case Command::SectorErase:
+      if (enable_write) {
+        state = State::ReadAddress0;
+      } else {
+        LOG_WARN("SPI: FIRM: attempted to write while write-protected.");
+        state = State::Ignore;
+      }
+      break;
     case Command::ReadStatus:
       state = State::ReadStatus;
       break;
     case Command::WriteEnable:
       enable_write = true;
       break;
+    case Command::WriteDisable:
+      enable_write = false;
+      break;
     default:
       ASSERT(false, "SPI: FIRM: unimplemented command: 0x{0:02X}", command);
   }
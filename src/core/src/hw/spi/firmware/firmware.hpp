@@ -4,7 +4,9 @@
 
 #pragma once
 
-#include <fstream>
+#include <string>
+#include <util/integer.hpp>
+#include <vector>
 
 #include "hw/spi/spi_device.hpp"
 
@@ -12,7 +14,14 @@ namespace Duality::Core {
 
 /// SPI firmware flash
 struct Firmware : SPIDevice {
+ ~Firmware() { Sync(); }
+
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
+
+  /// Write modified firmware data back to disk.
+  void Sync();
 
   void Select() override;
   void Deselect() override;
@@ -40,18 +49,31 @@ private:
     ReadAddress1,
     ReadAddress2,
     ReadData,
+    WriteData,
     ReadStatus,
-    Deselected
+    Deselected,
+    // Rejected or completed command, the remaining bytes are dropped until the next deselect.
+    Ignore
   };
 
+  static constexpr u32 kPageSize = 256;
+  static constexpr u32 kSectorSize = 0x10000;
+
+  static auto IsWriteCommand(Command command) -> bool;
+
   void ParseCommand(u8 command);
+  void Load();
 
   State state;
   Command command;
   u32 address;
   bool enable_write = false;
 
-  std::fstream file;
+  std::string path = "firmware.bin";
+  std::vector<u8> data;
+  u32 size = 0;
+  u32 mask = 0;
+  bool dirty = false;
 };
 
 } // namespace Duality::Core
@@ -20,6 +20,33 @@ void SPI::Reset() {
   tsc.Reset(firmware);
 }
 
+void SPI::LoadState(StateReader& state) {
+  state.Read(spicnt.baudrate);
+  state.Read(spicnt.busy);
+  state.Read(spicnt.device);
+  state.Read(spicnt.bugged_hword_mode);
+  state.Read(spicnt.chipselect_hold);
+  state.Read(spicnt.enable_irq);
+  state.Read(spicnt.enable);
+  state.Read(spidata.value);
+  state.Check(spicnt.device >= 0 && spicnt.device <= 3, "SPI: bad device in save state.");
+  firmware.LoadState(state);
+  tsc.LoadState(state);
+}
+
+void SPI::SaveState(StateWriter& state) {
+  state.Write(spicnt.baudrate);
+  state.Write(spicnt.busy);
+  state.Write(spicnt.device);
+  state.Write(spicnt.bugged_hword_mode);
+  state.Write(spicnt.chipselect_hold);
+  state.Write(spicnt.enable_irq);
+  state.Write(spicnt.enable);
+  state.Write(spidata.value);
+  firmware.SaveState(state);
+  tsc.SaveState(state);
+}
+
 auto SPI::SPICNT::ReadByte(uint offset) -> u8 {
   switch (offset) {
     case 0:
@@ -17,6 +17,8 @@ struct SPI {
   SPI(IRQ& irq7);
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
 
   Firmware firmware;
   TSC tsc;
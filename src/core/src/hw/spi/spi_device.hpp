@@ -6,6 +6,8 @@
 
 #include <util/integer.hpp>
 
+#include "save_state.hpp"
+
 namespace Duality::Core {
 
 struct SPIDevice {
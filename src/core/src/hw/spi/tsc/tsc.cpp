@@ -49,6 +49,14 @@ void TSC::Reset(Firmware& firmware) {
   firmware.Deselect();
 }
 
+void TSC::LoadState(StateReader& state) {
+  state.Read(data_reg);
+}
+
+void TSC::SaveState(StateWriter& state) {
+  state.Write(data_reg);
+}
+
 void TSC::SetInputDevice(InputDevice& device) {
   input_device = &device;
 }
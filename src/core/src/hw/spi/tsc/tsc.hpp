@@ -15,6 +15,8 @@ namespace Duality::Core {
 /// Asahi Kasei Microsystems AK4148AVT
 struct TSC : SPIDevice {
   void Reset(Firmware& firmware);
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   void SetInputDevice(InputDevice& device);
 
   void Select() override {}
@@ -11,17 +11,66 @@ namespace Duality::Core {
 static constexpr int g_ticks_shift[4] = { 0, 6, 8, 10 };
 static constexpr int g_ticks_mask[4] = { 0, 0x3F, 0xFF, 0x3FF };
 
+Timer::Timer(Scheduler& scheduler, IRQ& irq, Scheduler::EventClass event_class)
+    : scheduler(scheduler)
+    , irq(irq)
+    , event_class(event_class) {
+  scheduler.Register(event_class, [this](int cycles_late, u64 chan_id) {
+    auto& channel = channels[chan_id];
+    OnOverflow(channel);
+    StartChannel(channel, cycles_late);
+  });
+
+  Reset();
+}
+
 void Timer::Reset() {
   for (int id = 0; id < 4; id++) {
     auto& channel = channels[id];
     channel = {};
     channel.id = id;
-    channel.event_cb = [this, id](int cycles_late) {
-      // FIXME: ideally we would just capture the existing channel reference... not sure if it is possible.
-      auto& channel = channels[id];
-      OnOverflow(channel);
-      StartChannel(channel, cycles_late);
-    };
+  }
+}
+
+void Timer::LoadState(StateReader& state) {
+  int running_count = 0;
+
+  for (auto& channel : channels) {
+    state.Read(channel.reload);
+    state.Read(channel.counter);
+    state.Read(channel.control);
+    state.Read(channel.running);
+    state.Read(channel.shift);
+    state.Read(channel.mask);
+    state.Read(channel.timestamp_started);
+
+    auto frequency = channel.control.frequency;
+
+    state.Check(frequency >= 0 && frequency <= 3, "Timer: bad frequency in save state.");
+    state.Check(channel.shift == g_ticks_shift[frequency] && channel.mask == g_ticks_mask[frequency], "Timer: bad prescaler in save state.");
+    state.Check(channel.counter < 0x10000, "Timer: bad counter in save state.");
+
+    // The scheduler has been restored already, recover the event handle.
+    channel.event = channel.running ? scheduler.Find(event_class, channel.id) : nullptr;
+    state.Check(!channel.running || channel.event != nullptr, "Timer: missing overflow event in save state.");
+    if (channel.running) {
+      running_count++;
+    }
+  }
+
+  // Any other event would carry a channel ID the overflow handler does not expect.
+  state.Check(scheduler.Count(event_class) == running_count, "Timer: unexpected overflow event in save state.");
+}
+
+void Timer::SaveState(StateWriter& state) {
+  for (auto& channel : channels) {
+    state.Write(channel.reload);
+    state.Write(channel.counter);
+    state.Write(channel.control);
+    state.Write(channel.running);
+    state.Write(channel.shift);
+    state.Write(channel.mask);
+    state.Write(channel.timestamp_started);
   }
 }
 
@@ -120,7 +169,7 @@ void Timer::StartChannel(Channel& channel, int cycles_late) {
 
   channel.running = true;
   channel.timestamp_started = scheduler.GetTimestampNow() - cycles_late;
-  channel.event = scheduler.Add(cycles - cycles_late, channel.event_cb);
+  channel.event = scheduler.Add(cycles - cycles_late, event_class, channel.id);
 }
 
 void Timer::StopChannel(Channel& channel) {
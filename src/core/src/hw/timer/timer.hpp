@@ -12,12 +12,11 @@
 namespace Duality::Core {
 
 struct Timer {
-  Timer(Scheduler& scheduler, IRQ& irq)
-      : scheduler(scheduler), irq(irq) {
-    Reset();
-  }
+  Timer(Scheduler& scheduler, IRQ& irq, Scheduler::EventClass event_class);
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   auto Read (uint chan_id, uint offset) -> u8;
   void Write(uint chan_id, uint offset, u8 value);
 
@@ -44,11 +43,11 @@ private:
     int mask;
     u64 timestamp_started;
     Scheduler::Event* event = nullptr;
-    std::function<void(int)> event_cb;
   } channels[4];
 
   Scheduler& scheduler;
   IRQ& irq;
+  Scheduler::EventClass event_class;
 
   auto GetCounterDeltaSinceLastUpdate(Channel const& channel) -> u32;
   void StartChannel(Channel& channel, int cycles_late);
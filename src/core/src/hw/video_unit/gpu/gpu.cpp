@@ -5,6 +5,8 @@
 #include <util/log.hpp>
 
 #include "gpu.hpp"
+#include "profiler.hpp"
+#include "tracer.hpp"
 
 namespace Duality::Core {
 
@@ -40,6 +42,11 @@ GPU::GPU(Scheduler& scheduler, IRQ& irq9, DMA9& dma9, VRAM const& vram)
     , dma9(dma9)
     , vram_texture(vram.region_gpu_texture)
     , vram_palette(vram.region_gpu_palette) {
+  scheduler.Register(Scheduler::EventClass::GPU_CommandDone, [this](int, u64) {
+    gxstat.gx_busy = false;
+    ProcessCommands();
+  });
+
   Reset();
 }
 
@@ -73,6 +80,97 @@ void GPU::Reset() {
     output[i] = 0x8000;
 }
 
+void GPU::LoadState(StateReader& state) {
+  state.Read(disp3dcnt);
+  state.Read(gxstat.gx_busy);
+  state.Read(gxstat.cmd_fifo_irq);
+  state.Read(in_vertex_list);
+  state.Read(is_quad);
+  state.Read(is_strip);
+  state.Read(is_first);
+
+  // Only the used part of vertex and polygon RAM is stored.
+  for (int i = 0; i < 2; i++) {
+    state.Read(vertex[i].count);
+    state.Check(vertex[i].count >= 0 && vertex[i].count <= (int)std::size(vertex[i].data), "GPU: bad vertex count in save state");
+    state.Read(vertex[i].data, vertex[i].count * sizeof(Vertex));
+    state.Read(polygon[i].count);
+    state.Check(polygon[i].count >= 0 && polygon[i].count <= (int)std::size(polygon[i].data), "GPU: bad polygon count in save state");
+    state.Read(polygon[i].data, polygon[i].count * sizeof(Polygon));
+    for (int j = 0; j < polygon[i].count; j++) {
+      auto const& poly = polygon[i].data[j];
+      state.Check(poly.count >= 0 && poly.count <= (int)std::size(poly.indices), "GPU: bad polygon vertex count in save state");
+      for (int k = 0; k < poly.count; k++) {
+        state.Check(poly.indices[k] >= 0 && poly.indices[k] < vertex[i].count, "GPU: bad polygon vertex index in save state");
+      }
+    }
+  }
+  state.Read(gx_buffer_id);
+  state.Check(gx_buffer_id == 0 || gx_buffer_id == 1, "GPU: bad buffer ID in save state");
+
+  // A primitive is submitted as soon as it has four vertices at most.
+  auto vertex_count = state.Read<u32>();
+  state.Check(vertex_count < 4, "GPU: bad vertex count in save state");
+  vertices.resize(vertex_count);
+  state.Read(vertices.data(), vertices.size() * sizeof(Vertex));
+  state.Read(position_old);
+  state.Read(vertex_color);
+  state.Read(vertex_uv);
+  state.Read(texture_params);
+
+  state.Read(gxfifo);
+  state.Read(gxpipe);
+  state.Check(gxfifo.IsValid() && gxpipe.IsValid(), "GPU: bad command FIFO in save state");
+  state.Read(packed_cmds);
+  state.Read(packed_args_left);
+
+  state.Read(matrix_mode);
+  state.Read(projection);
+  state.Read(modelview);
+  state.Read(direction);
+  state.Read(texture);
+  state.Read(clip_matrix);
+  state.Check(matrix_mode >= MatrixMode::Projection && matrix_mode <= MatrixMode::Texture, "GPU: bad matrix mode in save state");
+  state.Check(projection.IsValid() && modelview.IsValid() && direction.IsValid() && texture.IsValid(), "GPU: bad matrix stack in save state");
+}
+
+void GPU::SaveState(StateWriter& state) {
+  state.Write(disp3dcnt);
+  state.Write(gxstat.gx_busy);
+  state.Write(gxstat.cmd_fifo_irq);
+  state.Write(in_vertex_list);
+  state.Write(is_quad);
+  state.Write(is_strip);
+  state.Write(is_first);
+
+  for (int i = 0; i < 2; i++) {
+    state.Write(vertex[i].count);
+    state.Write(vertex[i].data, vertex[i].count * sizeof(Vertex));
+    state.Write(polygon[i].count);
+    state.Write(polygon[i].data, polygon[i].count * sizeof(Polygon));
+  }
+  state.Write(gx_buffer_id);
+
+  state.Write(u32(vertices.size()));
+  state.Write(vertices.data(), vertices.size() * sizeof(Vertex));
+  state.Write(position_old);
+  state.Write(vertex_color);
+  state.Write(vertex_uv);
+  state.Write(texture_params);
+
+  state.Write(gxfifo);
+  state.Write(gxpipe);
+  state.Write(packed_cmds);
+  state.Write(packed_args_left);
+
+  state.Write(matrix_mode);
+  state.Write(projection);
+  state.Write(modelview);
+  state.Write(direction);
+  state.Write(texture);
+  state.Write(clip_matrix);
+}
+
 void GPU::WriteGXFIFO(u32 value) {
   u8 command;
   
@@ -145,6 +243,8 @@ auto GPU::Dequeue() -> CmdArgPack {
 }
 
 void GPU::ProcessCommands() {
+  Profiler::Scope scope{Profiler::Section::GPU_Commands};
+
   auto count = gxpipe.Count() + gxfifo.Count();
 
   if (count == 0 || gxstat.gx_busy) {
@@ -155,6 +255,8 @@ void GPU::ProcessCommands() {
   auto arg_count = kCmdNumParams[command];
 
   if (count >= arg_count) {
+    Tracer::Scope trace_scope{Tracer::Track::GPU, "GX command", "command", command};
+
     switch (command) {
       case 0x10: CMD_SetMatrixMode(); break;
       case 0x11: CMD_PushMatrix(); break;
@@ -196,10 +298,7 @@ void GPU::ProcessCommands() {
 
     // Fake the amount of time it takes to process the command.
     gxstat.gx_busy = true;
-    scheduler.Add(9, [this](int cycles_late) {
-      gxstat.gx_busy = false;
-      ProcessCommands();
-    });
+    scheduler.Add(9, Scheduler::EventClass::GPU_CommandDone);
   }
 }
 
@@ -13,6 +13,7 @@
 #include "hw/dma/dma9.hpp"
 #include "hw/irq/irq.hpp"
 #include "hw/video_unit/vram.hpp"
+#include "save_state.hpp"
 #include "scheduler.hpp"
 #include "color.hpp"
 #include "matrix_stack.hpp"
@@ -24,6 +25,8 @@ struct GPU {
   GPU(Scheduler& scheduler, IRQ& irq9, DMA9& dma9, VRAM const& vram);
   
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   void WriteGXFIFO(u32 value);
   void WriteCommandPort(uint port, u32 value);
 
@@ -62,6 +62,10 @@ struct MatrixStack {
     }
   }
   
+  bool IsValid() const {
+    return index >= 0 && index <= capacity;
+  }
+
   bool error;
   
   Matrix4<Fixed20x12> current;
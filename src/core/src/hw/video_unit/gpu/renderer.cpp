@@ -3,6 +3,8 @@
  */
 
 #include "gpu.hpp"
+#include "profiler.hpp"
+#include "tracer.hpp"
 
 namespace Duality::Core {
 
@@ -91,6 +93,9 @@ auto GPU::SampleTexture(TextureParams const& params, s16 u, s16 v) -> u16 {
 }
 
 void GPU::Render() {
+  Profiler::Scope scope{Profiler::Section::GPU_Render};
+  Tracer::Scope trace_scope{Tracer::Track::GPU, "GPU::Render"};
+
   for (uint i = 0; i < 256 * 192; i++) {
     output[i] = 0x8000;
     depthbuffer[i] = 0x7FFFFFFF;
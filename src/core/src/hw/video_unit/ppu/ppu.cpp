@@ -6,6 +6,8 @@
 #include <string.h>
 
 #include "ppu.hpp"
+#include "profiler.hpp"
+#include "tracer.hpp"
 
 namespace Duality::Core {
 
@@ -68,6 +70,48 @@ void PPU::Reset() {
   mmio.mosaic.Reset();
 }
 
+void PPU::LoadState(StateReader& state) {
+  state.Read(mmio);
+  state.Read(window_scanline_enable);
+
+  auto const& dispcnt = mmio.dispcnt;
+
+  state.Check(dispcnt.bg_mode >= 0 && dispcnt.bg_mode <= 7 && dispcnt.display_mode >= 0 && dispcnt.display_mode <= 3,
+    "PPU: bad display mode in save state.");
+  state.Check(dispcnt.vram_block >= 0 && dispcnt.vram_block <= 3 && dispcnt.tile_block >= 0 && dispcnt.tile_block <= 7 &&
+    dispcnt.map_block >= 0 && dispcnt.map_block <= 7, "PPU: bad display base address in save state.");
+  state.Check(dispcnt.tile_obj.boundary >= 0 && dispcnt.tile_obj.boundary <= 3 && dispcnt.bitmap_obj.boundary >= 0 &&
+    dispcnt.bitmap_obj.boundary <= 1 && dispcnt.bitmap_obj.dimension >= 0 && dispcnt.bitmap_obj.dimension <= 1,
+    "PPU: bad OBJ mapping in save state.");
+  state.Check(dispcnt.tile_obj.mapping <= DisplayControl::Mapping::OneDimensional &&
+    dispcnt.bitmap_obj.mapping <= DisplayControl::Mapping::OneDimensional, "PPU: bad OBJ mapping in save state.");
+
+  for (auto const& bgcnt : mmio.bgcnt) {
+    state.Check(bgcnt.priority >= 0 && bgcnt.priority <= 3 && bgcnt.size >= 0 && bgcnt.size <= 3 &&
+      bgcnt.palette_slot >= 0 && bgcnt.palette_slot <= 1, "PPU: bad background control in save state.");
+    state.Check(bgcnt.tile_block >= 0 && bgcnt.tile_block <= 15 && bgcnt.map_block >= 0 && bgcnt.map_block <= 31,
+      "PPU: bad background base address in save state.");
+  }
+
+  for (int i = 0; i < 4; i++) {
+    state.Check(mmio.bghofs[i].value <= 0x1FF && mmio.bgvofs[i].value <= 0x1FF, "PPU: bad background offset in save state.");
+  }
+
+  state.Check(mmio.bldcnt.sfx >= BlendControl::SFX_NONE && mmio.bldcnt.sfx <= BlendControl::SFX_DARKEN, "PPU: bad blend effect in save state.");
+  state.Check(mmio.bldalpha.a >= 0 && mmio.bldalpha.a <= 31 && mmio.bldalpha.b >= 0 && mmio.bldalpha.b <= 31 &&
+    mmio.bldy.y >= 0 && mmio.bldy.y <= 31, "PPU: bad blend factor in save state.");
+
+  for (auto const& mosaic : {mmio.mosaic.bg, mmio.mosaic.obj}) {
+    state.Check(mosaic.size_x >= 1 && mosaic.size_x <= 16 && mosaic.size_y >= 1 && mosaic.size_y <= 16 &&
+      mosaic._counter_y >= 0 && mosaic._counter_y < mosaic.size_y, "PPU: bad mosaic size in save state.");
+  }
+}
+
+void PPU::SaveState(StateWriter& state) {
+  state.Write(mmio);
+  state.Write(window_scanline_enable);
+}
+
 void PPU::OnDrawScanlineBegin(u16 vcount) {
   if (mmio.dispcnt.enable[ENABLE_WIN0]) {
     RenderWindow(0, vcount);
@@ -144,6 +188,9 @@ void PPU::OnBlankScanlineBegin(u16 vcount) {
 }
 
 void PPU::RenderScanline(u16 vcount) {
+  Profiler::Scope scope{Profiler::Section::PPU};
+  Tracer::Scope trace_scope{Tracer::Track::PPU, "PPU::RenderScanline", "vcount", vcount};
+
   switch (mmio.dispcnt.display_mode) {
     case 0:
       RenderDisplayOff(vcount);
@@ -9,6 +9,7 @@
 
 #include "hw/video_unit/vram.hpp"
 #include "registers.hpp"
+#include "save_state.hpp"
 
 namespace Duality::Core {
 
@@ -48,6 +49,8 @@ struct PPU {
   } mmio;
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   auto GetOutput() -> u32 const* { return &output[0]; }
   
   void OnDrawScanlineBegin(u16 vcount);
@@ -332,7 +332,7 @@ void Mosaic::Reset() {
   bg._counter_y = 0;
   obj.size_x = 1;
   obj.size_y = 1;
-  bg._counter_y = 0;
+  obj._counter_y = 0;
 }
 
 void Mosaic::WriteByte(uint offset, u8 value) {
@@ -12,8 +12,17 @@ static constexpr int kDrawingLines = 192;
 static constexpr int kBlankingLines = 71;
 static constexpr int kTotalLines = kDrawingLines + kBlankingLines;
 
-VideoUnit::VideoUnit(Scheduler& scheduler, IRQ& irq7, IRQ& irq9, DMA7& dma7, DMA9& dma9)
-    : gpu(scheduler, irq9, dma9, vram)
+VideoUnit::VideoUnit(
+  Scheduler& scheduler,
+  IRQ& irq7,
+  IRQ& irq9,
+  DMA7& dma7,
+  DMA9& dma9,
+  common::SharedMemory& memory
+)   : pram(memory.Allocate(0x1000))
+    , oam(memory.Allocate(0x1000))
+    , vram(memory)
+    , gpu(scheduler, irq9, dma9, vram)
     , ppu_a(0, vram, &pram[0x000], &oam[0x000], gpu.GetOutput())
     , ppu_b(1, vram, &pram[0x400], &oam[0x400])
     , scheduler(scheduler)
@@ -21,12 +30,15 @@ VideoUnit::VideoUnit(Scheduler& scheduler, IRQ& irq7, IRQ& irq9, DMA7& dma7, DMA
     , irq9(irq9)
     , dma7(dma7)
     , dma9(dma9) {
+  scheduler.Register(Scheduler::EventClass::VideoUnit_HdrawBegin, this, &VideoUnit::OnHdrawBegin);
+  scheduler.Register(Scheduler::EventClass::VideoUnit_HblankBegin, this, &VideoUnit::OnHblankBegin);
+
   Reset();
 }
 
 void VideoUnit::Reset() {
-  memset(pram, 0, sizeof(pram));
-  memset(oam, 0, sizeof(oam));
+  memset(pram, 0, 0x1000);
+  memset(oam, 0, 0x1000);
   vram.Reset();
   dispstat7 = {};
   dispstat9 = {};
@@ -47,6 +59,45 @@ void VideoUnit::Reset() {
   OnHdrawBegin(0);
 }
 
+void VideoUnit::LoadState(StateReader& state) {
+  for (auto dispstat : {&dispstat7, &dispstat9}) {
+    state.Read(dispstat->vblank);
+    state.Read(dispstat->hblank);
+    state.Read(dispstat->vcount);
+    state.Read(dispstat->vcount_setting);
+  }
+  state.Read(vcount.value);
+  state.Check(vcount.value < kTotalLines, "VideoUnit: bad VCOUNT in save state.");
+  state.Read(powcnt1);
+  state.Read(pram, 0x800);
+  state.Read(oam, 0x800);
+  memcpy(&pram[0x800], &pram[0], 0x800);
+  memcpy(&oam[0x800], &oam[0], 0x800);
+
+  vram.LoadState(state);
+  gpu.LoadState(state);
+  ppu_a.LoadState(state);
+  ppu_b.LoadState(state);
+}
+
+void VideoUnit::SaveState(StateWriter& state) {
+  for (auto dispstat : {&dispstat7, &dispstat9}) {
+    state.Write(dispstat->vblank);
+    state.Write(dispstat->hblank);
+    state.Write(dispstat->vcount);
+    state.Write(dispstat->vcount_setting);
+  }
+  state.Write(vcount.value);
+  state.Write(powcnt1);
+  state.Write(pram, 0x800);
+  state.Write(oam, 0x800);
+
+  vram.SaveState(state);
+  gpu.SaveState(state);
+  ppu_a.SaveState(state);
+  ppu_b.SaveState(state);
+}
+
 void VideoUnit::SetVideoDevice(VideoDevice& device) {
   video_device = &device;
 }
@@ -118,7 +169,7 @@ void VideoUnit::OnHdrawBegin(int late) {
     ppu_b.OnBlankScanlineBegin(vcount.value);    
   }
 
-  scheduler.Add(1606 - late, this, &VideoUnit::OnHblankBegin);
+  scheduler.Add(1606 - late, Scheduler::EventClass::VideoUnit_HblankBegin);
 }
 
 void VideoUnit::OnHblankBegin(int late) {
@@ -139,7 +190,7 @@ void VideoUnit::OnHblankBegin(int late) {
     ppu_b.OnDrawScanlineEnd();
   }
 
-  scheduler.Add(524 - late, this, &VideoUnit::OnHdrawBegin);
+  scheduler.Add(524 - late, Scheduler::EventClass::VideoUnit_HdrawBegin);
 }
 
 auto VideoUnit::DisplayStatus::ReadByte(uint offset) -> u8 {
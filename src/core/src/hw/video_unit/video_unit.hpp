@@ -7,6 +7,8 @@
 #include <functional>
 #include <util/integer.hpp>
 #include <util/log.hpp>
+#include <util/punning.hpp>
+#include <util/shared_memory.hpp>
 #include <core/device/video_device.hpp>
 
 #include "gpu/gpu.hpp"
@@ -23,9 +25,18 @@ namespace Duality::Core {
 struct VideoUnit {
   enum class Screen { Top, Bottom };
 
-  VideoUnit(Scheduler& scheduler, IRQ& irq7, IRQ& irq9, DMA7& dma7, DMA9& dma9);
+  VideoUnit(
+    Scheduler& scheduler,
+    IRQ& irq7,
+    IRQ& irq9,
+    DMA7& dma7,
+    DMA9& dma9,
+    common::SharedMemory& memory
+  );
 
   void Reset();
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
   void SetVideoDevice(VideoDevice& device);
   auto GetOutput(Screen screen) -> u32 const*;
 
@@ -74,8 +85,23 @@ struct VideoUnit {
     bool display_swap = false;
   } powcnt1;
 
-  u8 pram[0x800];
-  u8 oam[0x800];
+  /// PRAM and OAM are 2 KiB each, but are stored twice in a full memory page.
+  /// That way every mirror can be read through the fast memory pagetable.
+  /// Writes must go to both copies, use WritePRAM() and WriteOAM().
+  u8* pram;
+  u8* oam;
+
+  template<typename T>
+  void WritePRAM(u32 address, T value) {
+    write<T>(pram, (address & 0x7FF) | 0x000, value);
+    write<T>(pram, (address & 0x7FF) | 0x800, value);
+  }
+
+  template<typename T>
+  void WriteOAM(u32 address, T value) {
+    write<T>(oam, (address & 0x7FF) | 0x000, value);
+    write<T>(oam, (address & 0x7FF) | 0x800, value);
+  }
   VRAM vram;
   GPU gpu;
   PPU ppu_a;
@@ -6,7 +6,16 @@
 
 namespace Duality::Core {
 
-VRAM::VRAM() {
+VRAM::VRAM(common::SharedMemory& memory)
+    : bank_a(memory.Allocate<std::array<u8, 0x20000>>())
+    , bank_b(memory.Allocate<std::array<u8, 0x20000>>())
+    , bank_c(memory.Allocate<std::array<u8, 0x20000>>())
+    , bank_d(memory.Allocate<std::array<u8, 0x20000>>())
+    , bank_e(memory.Allocate<std::array<u8, 0x10000>>())
+    , bank_f(memory.Allocate<std::array<u8,  0x4000>>())
+    , bank_g(memory.Allocate<std::array<u8,  0x4000>>())
+    , bank_h(memory.Allocate<std::array<u8,  0x8000>>())
+    , bank_i(memory.Allocate<std::array<u8,  0x4000>>()) {
   Reset();
 }
 
@@ -32,6 +41,49 @@ void VRAM::Reset() {
   vramcnt_i.WriteByte(0);
 }
 
+/// NOTE: the bank contents are saved by the DirtyPageTracker.
+void VRAM::LoadState(StateReader& state) {
+  VRAMCNT* vramcnts[] {
+    &vramcnt_a, &vramcnt_b, &vramcnt_c, &vramcnt_d, &vramcnt_e,
+    &vramcnt_f, &vramcnt_g, &vramcnt_h, &vramcnt_i
+  };
+
+  // Unmap everything first, so that the banks can be remapped
+  // in the same order, regardless of the current mapping.
+  for (auto vramcnt : vramcnts) vramcnt->WriteByte(0);
+  for (auto vramcnt : vramcnts) vramcnt->WriteByte(state.Read<u8>());
+}
+
+void VRAM::SaveState(StateWriter& state) {
+  for (auto vramcnt : {&vramcnt_a, &vramcnt_b, &vramcnt_c, &vramcnt_d, &vramcnt_e,
+                       &vramcnt_f, &vramcnt_g, &vramcnt_h, &vramcnt_i}) {
+    state.Write(vramcnt->ReadByte());
+  }
+}
+
+void VRAM::SetDirtyPageTracker(DirtyPageTracker& tracker) {
+  tracker.AddRegion(bank_a.data(), bank_a.size());
+  tracker.AddRegion(bank_b.data(), bank_b.size());
+  tracker.AddRegion(bank_c.data(), bank_c.size());
+  tracker.AddRegion(bank_d.data(), bank_d.size());
+  tracker.AddRegion(bank_e.data(), bank_e.size());
+  tracker.AddRegion(bank_f.data(), bank_f.size());
+  tracker.AddRegion(bank_g.data(), bank_g.size());
+  tracker.AddRegion(bank_h.data(), bank_h.size());
+  tracker.AddRegion(bank_i.data(), bank_i.size());
+
+  region_ppu_bg[0].SetDirtyPageTracker(&tracker);
+  region_ppu_bg[1].SetDirtyPageTracker(&tracker);
+  region_ppu_obj[0].SetDirtyPageTracker(&tracker);
+  region_ppu_obj[1].SetDirtyPageTracker(&tracker);
+  region_lcdc.SetDirtyPageTracker(&tracker);
+  region_arm7_wram.SetDirtyPageTracker(&tracker);
+}
+
+auto VRAM::VRAMCNT::ReadByte() const -> u8 {
+  return mst | (offset << 3) | (enable ? 0x80 : 0);
+}
+
 void VRAM::VRAMCNT::WriteByte(u8 value) {
   if (enable) {
     vram.UnmapFromCurrent(bank);
@@ -6,7 +6,10 @@
 
 #include <util/integer.hpp>
 #include <util/likely.hpp>
+#include <util/shared_memory.hpp>
 
+#include "dirty_page_tracker.hpp"
+#include "save_state.hpp"
 #include "vram_region.hpp"
 
 namespace Duality::Core {
@@ -25,20 +28,26 @@ struct VRAM {
     I = 8
   };
 
-  VRAM();
+  VRAM(common::SharedMemory& memory);
 
   void Reset();
-
-  /// VRAM banks A - I (total: 656 KiB)
-  std::array<u8, 0x20000> bank_a; // 128 KiB
-  std::array<u8, 0x20000> bank_b; // 128 KiB
-  std::array<u8, 0x20000> bank_c; // 128 KiB
-  std::array<u8, 0x20000> bank_d; // 128 KiB
-  std::array<u8, 0x10000> bank_e; //  64 KiB
-  std::array<u8,  0x4000> bank_f; //  16 KiB
-  std::array<u8,  0x4000> bank_g; //  16 KiB
-  std::array<u8,  0x8000> bank_h; //  32 KiB
-  std::array<u8,  0x4000> bank_i; //  16 KiB
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
+
+  /// Register the VRAM banks for dirty page tracking and
+  /// let the CPU-writable regions mark the pages they write to.
+  void SetDirtyPageTracker(DirtyPageTracker& tracker);
+
+  /// VRAM banks A - I (total: 656 KiB), allocated from the shared memory pool
+  std::array<u8, 0x20000>& bank_a; // 128 KiB
+  std::array<u8, 0x20000>& bank_b; // 128 KiB
+  std::array<u8, 0x20000>& bank_c; // 128 KiB
+  std::array<u8, 0x20000>& bank_d; // 128 KiB
+  std::array<u8, 0x10000>& bank_e; //  64 KiB
+  std::array<u8,  0x4000>& bank_f; //  16 KiB
+  std::array<u8,  0x4000>& bank_g; //  16 KiB
+  std::array<u8,  0x8000>& bank_h; //  32 KiB
+  std::array<u8,  0x4000>& bank_i; //  16 KiB
 
   /// LCDC and PPU A / B VRAM mapping
   Region<32> region_ppu_bg [2] { 31, 7 };
@@ -62,6 +71,7 @@ struct VRAM {
   struct VRAMCNT {
     VRAMCNT(VRAM& vram, Bank bank) : vram(vram), bank(bank) {}
 
+    auto ReadByte() const -> u8;
     void WriteByte(u8 value);
   private:
     friend struct VRAM;
@@ -14,6 +14,8 @@
 #include <stddef.h>
 #include <vector>
 
+#include "dirty_page_tracker.hpp"
+
 namespace Duality::Core {
 
 template<size_t page_count, u32 page_size = 16384>
@@ -26,6 +28,11 @@ struct Region {
     callbacks.push_back(callback);
   }
 
+  /// Writes through this region will mark the written pages as dirty.
+  void SetDirtyPageTracker(DirtyPageTracker* tracker) {
+    dirty_pages = tracker;
+  }
+
   template<typename T>
   auto Read(u32 offset) const -> T {
     static_assert(common::is_one_of_v<T, u8, u16, u32, u64>, "T must be u8, u16, u32 or u64"); 
@@ -54,11 +61,14 @@ struct Region {
     offset &= kPageMask & ~(sizeof(T) - 1);
     if (likely(desc.page != nullptr)) {
       *reinterpret_cast<T*>(&desc.page[offset]) = value;
+      if (dirty_pages != nullptr) dirty_pages->Mark(&desc.page[offset]);
       return;
     }
     if (unlikely(desc.pages != nullptr)) {
-      for (u8* page : *desc.pages) // ???
+      for (u8* page : *desc.pages) { // ???
         *reinterpret_cast<T*>(&page[offset]) = value;
+        if (dirty_pages != nullptr) dirty_pages->Mark(&page[offset]);
+      }
     }
   }
 
@@ -152,6 +162,7 @@ private:
   size_t mask;
   std::array<PageDescriptor, page_count> pages {};
   std::vector<Callback> callbacks;
+  DirtyPageTracker* dirty_pages = nullptr;
 
   static constexpr int kPageShift = []() constexpr -> int {
     for (int i = 0; i < 32; i++)
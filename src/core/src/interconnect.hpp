@@ -6,11 +6,14 @@
 
 #include <util/integer.hpp>
 #include <util/log.hpp>
+#include <util/shared_memory.hpp>
 #include <core/device/input_device.hpp>
 #include <functional>
 #include <string.h>
 #include <vector>
 
+#include "cpu_sync.hpp"
+#include "dirty_page_tracker.hpp"
 #include "hw/apu/apu.hpp"
 #include "hw/cart/cart.hpp"
 #include "hw/dma/dma7.hpp"
@@ -21,6 +24,7 @@
 #include "hw/spi/spi.hpp"
 #include "hw/timer/timer.hpp"
 #include "hw/video_unit/video_unit.hpp"
+#include "save_state.hpp"
 #include "scheduler.hpp"
 
 namespace Duality::Core {
@@ -28,22 +32,29 @@ namespace Duality::Core {
 // TODO: this whole construct really needs to go away :methharold:
 struct Interconnect {
   Interconnect()
-      : apu(scheduler)
+      : ewram(memory.Allocate(0x400000))
+      , apu(scheduler)
       , cart(irq7, irq9, dma7, dma9) 
+      , irq7(Tracer::Track::ARM7)
+      , irq9(Tracer::Track::ARM9)
       , ipc(irq7, irq9)
       , spi(irq7)
-      , timer7(scheduler, irq7)
-      , timer9(scheduler, irq9)
-      , dma7(irq7)
-      , dma9(irq9)
-      , video_unit(scheduler, irq7, irq9, dma7, dma9)
+      , timer7(scheduler, irq7, Scheduler::EventClass::ARM7_TimerOverflow)
+      , timer9(scheduler, irq9, Scheduler::EventClass::ARM9_TimerOverflow)
+      , dma7(scheduler, irq7)
+      , dma9(scheduler, irq9)
+      , video_unit(scheduler, irq7, irq9, dma7, dma9, memory)
       , wramcnt(swram) {
+    swram.data = memory.Allocate(0x8000);
+    dirty_pages.AddRegion(ewram, 0x400000);
+    dirty_pages.AddRegion(swram.data, 0x8000);
+    video_unit.vram.SetDirtyPageTracker(dirty_pages);
     Reset();
   }
 
   void Reset() {
-    memset(ewram, 0, sizeof(ewram));
-    memset(swram.data, 0, sizeof(swram));
+    memset(ewram, 0, 0x400000);
+    memset(swram.data, 0, 0x8000);
     
     scheduler.Reset();
     apu.Reset();
@@ -62,6 +73,49 @@ struct Interconnect {
     // TODO: this is the value for direct boot,
     // which value is correct for firmware boot?
     wramcnt.WriteByte(3);
+
+    dirty_pages.MarkAll();
+  }
+
+  /// NOTE: the scheduler must be restored first, because other
+  /// components recover their pending events from it.
+  /// Guest RAM (including ARM7 IWRAM and VRAM) is restored by the DirtyPageTracker.
+  void LoadState(StateReader& state) {
+    scheduler.LoadState(state);
+    dirty_pages.LoadState(state);
+    wramcnt.WriteByte(state.Read<u8>());
+
+    apu.LoadState(state);
+    cart.LoadState(state);
+    irq7.LoadState(state);
+    irq9.LoadState(state);
+    math_engine.LoadState(state);
+    ipc.LoadState(state);
+    spi.LoadState(state);
+    timer7.LoadState(state);
+    timer9.LoadState(state);
+    dma7.LoadState(state);
+    dma9.LoadState(state);
+    video_unit.LoadState(state);
+  }
+
+  void SaveState(StateWriter& state, bool incremental) {
+    scheduler.SaveState(state);
+    dirty_pages.SaveState(state, incremental);
+    state.Write(wramcnt.ReadByte());
+
+    apu.SaveState(state);
+    cart.SaveState(state);
+    irq7.SaveState(state);
+    irq9.SaveState(state);
+    math_engine.SaveState(state);
+    ipc.SaveState(state);
+    spi.SaveState(state);
+    timer7.SaveState(state);
+    timer9.SaveState(state);
+    dma7.SaveState(state);
+    dma9.SaveState(state);
+    video_unit.SaveState(state);
   }
 
   void SetInputDevice(InputDevice& device) {
@@ -70,10 +124,14 @@ struct Interconnect {
     spi.tsc.SetInputDevice(device);
   }
 
-  u8 ewram[0x400000];
+  /// Guest RAM, VRAM and BIOS are allocated from this pool, so that the CPUs can
+  /// mirror them in their fast memory arenas (see arm::FastMemoryArena).
+  common::SharedMemory memory { 0x800000 };
+
+  u8* ewram;
 
   struct SWRAM {
-    u8 data[0x8000];
+    u8* data = nullptr;
 
     struct Alloc {
       u8* data = nullptr;
@@ -81,6 +139,8 @@ struct Interconnect {
     } arm9 = {}, arm7 = {};
   } swram;
 
+  DirtyPageTracker dirty_pages;
+  CPUSync cpu_sync;
   Scheduler scheduler;
   APU apu;
   Cartridge cart;
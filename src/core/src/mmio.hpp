@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <util/integer.hpp>
+#include <util/log.hpp>
+#include <vector>
+
+namespace Duality::Core {
+
+/// Page-indexed dispatch table for memory-mapped I/O registers.
+/// Hardware blocks register read and write handlers per address and access width.
+/// An access is dispatched with two table lookups. If no handler exists for its width,
+/// the access is split into two accesses of half the width, down to single bytes.
+struct MMIO {
+  template<typename T>
+  using ReadHandler = std::function<T(u32 address)>;
+
+  template<typename T>
+  using WriteHandler = std::function<void(u32 address, T value)>;
+
+  MMIO(std::string name) : name(std::move(name)) {
+    // Index zero marks addresses without a handler.
+    std::get<0>(read_handlers).emplace_back();
+    std::get<1>(read_handlers).emplace_back();
+    std::get<2>(read_handlers).emplace_back();
+    std::get<0>(write_handlers).emplace_back();
+    std::get<1>(write_handlers).emplace_back();
+    std::get<2>(write_handlers).emplace_back();
+  }
+
+  template<typename T>
+  auto Read(u32 address) -> T {
+    auto page = pages[(address >> kPageShift) & kPageIndexMask].get();
+
+    if (page != nullptr) {
+      auto index = page->template ReadIndex<T>(address);
+      if (index != 0) {
+        return std::get<Width<T>()>(read_handlers)[index](address);
+      }
+    }
+
+    if constexpr (std::is_same_v<T, u8>) {
+      LOG_WARN("{0}: MMIO: unhandled read from 0x{1:08X}", name, address);
+      return 0;
+    } else {
+      using Half = Narrow<T>;
+      return Read<Half>(address) | (T(Read<Half>(address + sizeof(Half))) << (sizeof(Half) * 8));
+    }
+  }
+
+  template<typename T>
+  void Write(u32 address, T value) {
+    auto page = pages[(address >> kPageShift) & kPageIndexMask].get();
+
+    if (page != nullptr) {
+      auto index = page->template WriteIndex<T>(address);
+      if (index != 0) {
+        std::get<Width<T>()>(write_handlers)[index](address, value);
+        return;
+      }
+    }
+
+    if constexpr (std::is_same_v<T, u8>) {
+      LOG_WARN("{0}: MMIO: unhandled write to 0x{1:08X} = 0x{2:02X}", name, address, value);
+    } else {
+      using Half = Narrow<T>;
+      Write<Half>(address, Half(value));
+      Write<Half>(address + sizeof(Half), Half(value >> (sizeof(Half) * 8)));
+    }
+  }
+
+  /// Register a handler for accesses of width T to the register at `address`.
+  template<typename T>
+  void MapRead(u32 address, ReadHandler<T> handler) {
+    MapReadRange<T>(address, address, std::move(handler));
+  }
+
+  template<typename T>
+  void MapWrite(u32 address, WriteHandler<T> handler) {
+    MapWriteRange<T>(address, address, std::move(handler));
+  }
+
+  /// Register one handler for all accesses of width T between `address_lo` and `address_hi` (inclusive).
+  template<typename T>
+  void MapReadRange(u32 address_lo, u32 address_hi, ReadHandler<T> handler) {
+    auto& handlers = std::get<Width<T>()>(read_handlers);
+    auto index = u16(handlers.size());
+    ASSERT(index != 0, "{0}: MMIO: too many read handlers", name);
+    handlers.push_back(std::move(handler));
+    for (u32 address = address_lo; address <= address_hi; address += sizeof(T)) {
+      GetOrCreatePage(address).template ReadIndex<T>(address) = index;
+    }
+  }
+
+  template<typename T>
+  void MapWriteRange(u32 address_lo, u32 address_hi, WriteHandler<T> handler) {
+    auto& handlers = std::get<Width<T>()>(write_handlers);
+    auto index = u16(handlers.size());
+    ASSERT(index != 0, "{0}: MMIO: too many write handlers", name);
+    handlers.push_back(std::move(handler));
+    for (u32 address = address_lo; address <= address_hi; address += sizeof(T)) {
+      GetOrCreatePage(address).template WriteIndex<T>(address) = index;
+    }
+  }
+
+  /// Register a T-sized register that is accessed one byte at a time,
+  /// via `read(offset)` where offset is relative to `address`.
+  /// Every byte gets its own handler, wider accesses are served by a single handler
+  /// which assembles the value from the individual bytes.
+  template<typename T, typename Functor>
+  void MapReadBytes(u32 address, Functor read) {
+    for (uint i = 0; i < sizeof(T); i++) {
+      MapRead<u8>(address + i, [read, i](u32) { return u8(read(i)); });
+    }
+    if constexpr (sizeof(T) >= 2) {
+      for (uint i = 0; i < sizeof(T); i += 2) {
+        MapRead<u16>(address + i, [read, i](u32) {
+          return u16(read(i | 0) | (read(i | 1) << 8));
+        });
+      }
+    }
+    if constexpr (sizeof(T) == 4) {
+      MapRead<u32>(address, [read](u32) {
+        return u32(read(0) | (read(1) << 8) | (read(2) << 16) | (u32(read(3)) << 24));
+      });
+    }
+  }
+
+  /// Register a T-sized register that is written one byte at a time,
+  /// via `write(offset, value)` where offset is relative to `address`.
+  /// Wider accesses write the individual bytes in ascending order.
+  template<typename T, typename Functor>
+  void MapWriteBytes(u32 address, Functor write) {
+    for (uint i = 0; i < sizeof(T); i++) {
+      MapWrite<u8>(address + i, [write, i](u32, u8 value) { write(i, value); });
+    }
+    if constexpr (sizeof(T) >= 2) {
+      for (uint i = 0; i < sizeof(T); i += 2) {
+        MapWrite<u16>(address + i, [write, i](u32, u16 value) {
+          write(i | 0, u8(value));
+          write(i | 1, u8(value >> 8));
+        });
+      }
+    }
+    if constexpr (sizeof(T) == 4) {
+      MapWrite<u32>(address, [write](u32, u32 value) {
+        write(0, u8(value >>  0));
+        write(1, u8(value >>  8));
+        write(2, u8(value >> 16));
+        write(3, u8(value >> 24));
+      });
+    }
+  }
+
+  /// Shorthands for register structs with ReadByte(offset) and WriteByte(offset, value) methods.
+  template<typename T, typename Register>
+  void MapReadRegister(u32 address, Register& reg) {
+    MapReadBytes<T>(address, [&reg](uint offset) { return reg.ReadByte(offset); });
+  }
+
+  template<typename T, typename Register>
+  void MapWriteRegister(u32 address, Register& reg) {
+    MapWriteBytes<T>(address, [&reg](uint offset, u8 value) { reg.WriteByte(offset, value); });
+  }
+
+  template<typename T, typename Register>
+  void MapRegister(u32 address, Register& reg) {
+    MapReadRegister<T>(address, reg);
+    MapWriteRegister<T>(address, reg);
+  }
+
+private:
+  static constexpr int kPageShift = 12;
+  static constexpr u32 kPageMask = (1 << kPageShift) - 1;
+
+  /// The I/O region spans 16 MiB, the top byte of the address is ignored.
+  static constexpr u32 kPageIndexMask = 0xFFF;
+
+  template<typename T>
+  static constexpr auto Width() -> int {
+    static_assert(std::is_same_v<T, u8> || std::is_same_v<T, u16> || std::is_same_v<T, u32>);
+    return sizeof(T) == 1 ? 0 : (sizeof(T) == 2 ? 1 : 2);
+  }
+
+  template<typename T>
+  using Narrow = std::conditional_t<std::is_same_v<T, u32>, u16, u8>;
+
+  /// Per address and width the index of the handler, zero if there is none.
+  struct Page {
+    std::array<u16, 1 << kPageShift> read8 {};
+    std::array<u16, 1 << kPageShift> write8 {};
+    std::array<u16, 1 << (kPageShift - 1)> read16 {};
+    std::array<u16, 1 << (kPageShift - 1)> write16 {};
+    std::array<u16, 1 << (kPageShift - 2)> read32 {};
+    std::array<u16, 1 << (kPageShift - 2)> write32 {};
+
+    template<typename T>
+    auto ReadIndex(u32 address) -> u16& {
+      auto offset = (address & kPageMask) / sizeof(T);
+      if constexpr (std::is_same_v<T, u8>)  return read8[offset];
+      if constexpr (std::is_same_v<T, u16>) return read16[offset];
+      if constexpr (std::is_same_v<T, u32>) return read32[offset];
+    }
+
+    template<typename T>
+    auto WriteIndex(u32 address) -> u16& {
+      auto offset = (address & kPageMask) / sizeof(T);
+      if constexpr (std::is_same_v<T, u8>)  return write8[offset];
+      if constexpr (std::is_same_v<T, u16>) return write16[offset];
+      if constexpr (std::is_same_v<T, u32>) return write32[offset];
+    }
+  };
+
+  auto GetOrCreatePage(u32 address) -> Page& {
+    auto& page = pages[(address >> kPageShift) & kPageIndexMask];
+    if (!page) {
+      page = std::make_unique<Page>();
+    }
+    return *page;
+  }
+
+  std::string name;
+  std::array<std::unique_ptr<Page>, kPageIndexMask + 1> pages;
+
+  std::tuple<
+    std::vector<ReadHandler<u8>>,
+    std::vector<ReadHandler<u16>>,
+    std::vector<ReadHandler<u32>>
+  > read_handlers;
+
+  std::tuple<
+    std::vector<WriteHandler<u8>>,
+    std::vector<WriteHandler<u16>>,
+    std::vector<WriteHandler<u32>>
+  > write_handlers;
+};
+
+} // namespace Duality::Core
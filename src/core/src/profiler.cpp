@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <fmt/format.h>
+#include <util/log.hpp>
+
+#include "profiler.hpp"
+
+namespace Duality::Core {
+
+static constexpr const char* kSectionNames[Profiler::kSectionCount] {
+  "ARM9::Run",
+  "ARM7::Run",
+  "Scheduler::Step",
+  "PPU::RenderScanline",
+  "GPU::Render",
+  "GPU::ProcessCommands",
+  "APU::Mix",
+  "DMA9::RunChannel",
+  "DMA7::RunChannel"
+};
+
+void Profiler::NextFrame() {
+  if constexpr (!gEnableProfiling) {
+    return;
+  }
+
+  auto now = Now();
+
+  frame_ticks = now - frame_start;
+  frame_start = now;
+  accumulated_frame_ticks += frame_ticks;
+
+  for (int i = 0; i < kSectionCount; i++) {
+    last_frame[i] = {};
+    for (auto& thread : threads) {
+      last_frame[i].ticks += thread[i].ticks;
+      last_frame[i].calls += thread[i].calls;
+      thread[i] = {};
+    }
+    accumulated[i].ticks += last_frame[i].ticks;
+    accumulated[i].calls += last_frame[i].calls;
+  }
+
+  accumulated_slices.slices += current_slices.slices;
+  accumulated_slices.cycles += current_slices.cycles;
+  accumulated_slices.shared += current_slices.shared;
+  current_slices = {};
+
+  if (++frame_count == kReportInterval) {
+    LOG_INFO("Profiler: average over {0} frames:\n{1}", kReportInterval, GetReport());
+
+    for (auto& counter : accumulated) counter = {};
+    accumulated_slices = {};
+    accumulated_frame_ticks = 0;
+    frame_count = 0;
+  }
+}
+
+auto Profiler::GetReport() const -> std::string {
+  std::string report;
+
+  if (!gEnableProfiling || frame_count == 0 || accumulated_frame_ticks == 0) {
+    return report;
+  }
+
+  for (int i = 0; i < kSectionCount; i++) {
+    auto const& counter = accumulated[i];
+
+    report += fmt::format("  {0:<22} {1:>12} ticks {2:>6.2f}% {3:>9} calls\n",
+      kSectionNames[i],
+      counter.ticks / frame_count,
+      counter.ticks * 100.0 / accumulated_frame_ticks,
+      counter.calls / frame_count);
+  }
+
+  if (accumulated_slices.slices != 0) {
+    report += fmt::format("  {0:<22} {1:>12} slices {2:>6.1f} cycles avg {3:>9} shared\n",
+      "CPU slices",
+      accumulated_slices.slices / frame_count,
+      double(accumulated_slices.cycles) / accumulated_slices.slices,
+      accumulated_slices.shared / frame_count);
+  }
+
+  report += fmt::format("  {0:<22} {1:>12} ticks", "Frame", accumulated_frame_ticks / frame_count);
+  return report;
+}
+
+} // namespace Duality::Core
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <buildconfig.hpp>
+#include <chrono>
+#include <string>
+#include <type_traits>
+#include <util/integer.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace Duality::Core {
+
+/// Per-subsystem host time counters, aggregated once per emulated frame.
+/// Each core owns a profiler, the threads running a core bind it with Bind().
+/// Every thread counts into its own slot, the slots are merged by NextFrame().
+/// Everything in here compiles to nothing unless gEnableProfiling is set.
+struct Profiler {
+  enum class Section {
+    ARM9,
+    ARM7,
+    Scheduler,
+    PPU,
+    GPU_Render,
+    GPU_Commands,
+    APU_Mixer,
+    DMA9,
+    DMA7,
+    Count
+  };
+
+  static constexpr int kSectionCount = static_cast<int>(Section::Count);
+
+  /// Host threads that run parts of a core.
+  enum class Thread {
+    Emulation,
+    ARM7,
+    Count
+  };
+
+  static constexpr int kThreadCount = static_cast<int>(Thread::Count);
+
+  /// Number of frames over which the report is averaged.
+  static constexpr int kReportInterval = 60;
+
+  struct Counter {
+    u64 ticks = 0;
+    u64 calls = 0;
+  };
+
+  /// CPU slices run by CoreImpl::Run()
+  struct SliceCounter {
+    u64 slices = 0;
+    u64 cycles = 0;
+    /// Slices in which a CPU accessed registers shared with the other CPU.
+    u64 shared = 0;
+  };
+
+  static auto Now() -> u64 {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  /// RAII helper that makes the calling thread count into one of the profiler's slots.
+  struct Bind {
+    Bind(Profiler& profiler, Thread thread) {
+      if constexpr (gEnableProfiling) {
+        previous = current;
+        current = profiler.threads[static_cast<int>(thread)];
+      }
+    }
+
+   ~Bind() {
+      if constexpr (gEnableProfiling) {
+        current = previous;
+      }
+    }
+
+  private:
+    Counter* previous = nullptr;
+  };
+
+  void AddSlice(uint cycles, bool shared) {
+    if constexpr (gEnableProfiling) {
+      current_slices.slices++;
+      current_slices.cycles += cycles;
+      current_slices.shared += shared ? 1 : 0;
+    }
+  }
+
+  /// Closes the current frame and emits a report every kReportInterval frames.
+  /// Must only be called while no other thread is running the core.
+  void NextFrame();
+
+  auto GetLastFrame(Section section) const -> Counter const& {
+    return last_frame[static_cast<int>(section)];
+  }
+
+  auto GetReport() const -> std::string;
+
+  /// RAII helper that attributes the host time spent in its scope to a section.
+  /// NOTE: sections are inclusive, e.g. DMA time is also counted for the CPU
+  /// whose I/O write started the transfer. Sections of different threads may overlap.
+  struct TimedScope {
+    TimedScope(Section section) : section(section), start(Now()) {}
+   ~TimedScope() {
+      if (current != nullptr) {
+        auto& counter = current[static_cast<int>(section)];
+        counter.ticks += Now() - start;
+        counter.calls++;
+      }
+    }
+
+  private:
+    Section section;
+    u64 start;
+  };
+
+  struct NullScope {
+    constexpr NullScope(Section) {}
+  };
+
+  using Scope = std::conditional_t<gEnableProfiling, TimedScope, NullScope>;
+
+private:
+  static inline thread_local Counter* current = nullptr;
+
+  Counter threads[kThreadCount][kSectionCount];
+  Counter last_frame[kSectionCount];
+  Counter accumulated[kSectionCount];
+  SliceCounter current_slices;
+  SliceCounter accumulated_slices;
+  u64 frame_start = Now();
+  u64 frame_ticks = 0;
+  u64 accumulated_frame_ticks = 0;
+  int frame_count = 0;
+};
+
+} // namespace Duality::Core
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <stdexcept>
+#include <string.h>
+#include <type_traits>
+#include <util/integer.hpp>
+#include <util/log.hpp>
+#include <vector>
+
+namespace Duality::Core {
+
+/// Appends raw component state to a save state buffer.
+/// Components are expected to group their state into as few
+/// trivially copyable blocks as possible, so that saving boils down
+/// to a handful of large memcpys.
+struct StateWriter {
+  StateWriter(std::vector<u8>& buffer) : buffer(buffer) {}
+
+  void Write(void const* data, size_t size) {
+    auto bytes = static_cast<u8 const*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+  }
+
+  template<typename T>
+  void Write(T const& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "StateWriter: T must be trivially copyable");
+    Write(&value, sizeof(T));
+  }
+
+private:
+  std::vector<u8>& buffer;
+};
+
+/// Thrown by StateReader if the save state is truncated or contains invalid values.
+struct StateError : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+/// Reads back component state in the same order that it was written.
+/// Components may be left half-loaded when a StateError is thrown.
+struct StateReader {
+  StateReader(u8 const* data, size_t size) : data(data), size(size) {}
+
+  void Read(void* data, size_t size) {
+    Check(size <= Remaining(), "StateReader: attempted to read past the end of the save state.");
+    memcpy(data, this->data + offset, size);
+    offset += size;
+  }
+
+  template<typename T>
+  void Read(T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "StateReader: T must be trivially copyable");
+    Read(&value, sizeof(T));
+  }
+
+  template<typename T>
+  auto Read() -> T {
+    T value;
+    Read(value);
+    return value;
+  }
+
+  void Skip(size_t size) {
+    Check(size <= Remaining(), "StateReader: attempted to skip past the end of the save state.");
+    offset += size;
+  }
+
+  /// Validate a value that was read from the save state.
+  void Check(bool condition, const char* message) {
+    if (!condition) {
+      throw StateError{message};
+    }
+  }
+
+  auto Remaining() const -> size_t { return size - offset; }
+
+private:
+  u8 const* data;
+  size_t size;
+  size_t offset = 0;
+};
+
+} // namespace Duality::Core
@@ -2,93 +2,418 @@
  * Copyright (C) 2020 fleroviux
  */
 
+#include <algorithm>
+
+#include "profiler.hpp"
 #include "scheduler.hpp"
+#include "tracer.hpp"
 
 namespace Duality::Core {
 
+/// Index of the highest set bit, value must not be zero.
+static inline int HighestSetBit(u64 value) {
+#if defined(__has_builtin) && __has_builtin(__builtin_clzll)
+  return 63 - __builtin_clzll(value);
+#else
+  int bit = 63;
+  while ((value >> bit) == 0) bit--;
+  return bit;
+#endif
+}
+
+/// Index of the lowest set bit, value must not be zero.
+static inline int LowestSetBit(u64 value) {
+#if defined(__has_builtin) && __has_builtin(__builtin_ctzll)
+  return __builtin_ctzll(value);
+#else
+  int bit = 0;
+  while (((value >> bit) & 1) == 0) bit++;
+  return bit;
+#endif
+}
+
 Scheduler::Scheduler() {
-  for (int i = 0; i < kMaxEvents; i++) {
-    heap[i] = new Event();
-    heap[i]->handle = i;
-  }
   Reset();
 }
 
 Scheduler::~Scheduler() {
-  for (int i = 0; i < kMaxEvents; i++) {
-    delete heap[i];
-  }
 }
 
 void Scheduler::Reset() {
-  heap_size = 0;
+  ForEachEvent([this](Event* event) { FreeEvent(event); });
+
+  for (auto& level : levels) {
+    level = {};
+  }
+
+  heap.clear();
+  next_sequence = 0;
+  event_count = 0;
   timestamp_now = 0;
+  timestamp_wheel = 0;
+  timestamp_target = std::numeric_limits<u64>::max();
 }
 
 void Scheduler::Step() {
+  Profiler::Scope scope{Profiler::Section::Scheduler};
+
   auto now = GetTimestampNow();
-  while (heap_size > 0 && heap[0]->timestamp <= now) {
-    auto event = heap[0];
-    event->callback(int(now - event->timestamp));
-    // NOTE: we cannot just pass zero because the callback may mess with the event queue.
-    Remove(event->handle);
+  while (timestamp_target <= now) {
+    Event* event;
+
+    if constexpr (gUseTimingWheelScheduler) {
+      // Once the wheel is at the time of the next event,
+      // that event is the first one in the current level 0 slot.
+      Advance(timestamp_target);
+      event = levels[0].slots[timestamp_target & (kSlotCount - 1)].head;
+    } else {
+      event = heap[0];
+    }
+
+    auto cycles_late = int(now - event->timestamp);
+    Unlink(event);
+
+    Tracer::Scope trace_scope{Tracer::Track::Scheduler, "Event", "class", u64(event->event_class)};
+    callbacks[static_cast<int>(event->event_class)](cycles_late, event->user_data);
+    // NOTE: the event is only recycled now, so that the callback cannot get it back from Add().
+    FreeEvent(event);
   }
-}
 
-auto Scheduler::Add(u64 delay, std::function<void(int)> callback) -> Event* {
-  int n = heap_size++;
-  int p = Parent(n);
+  // Keeps new events in the lowest possible levels.
+  Advance(now);
+}
 
-  ASSERT(heap_size <= kMaxEvents, "exceeded maximum number of scheduler events.");
+void Scheduler::Register(EventClass event_class, Callback callback) {
+  callbacks[static_cast<int>(event_class)] = callback;
+}
 
-  auto event = heap[n];
+auto Scheduler::Add(u64 delay, EventClass event_class, u64 user_data) -> Event* {
+  auto event = AllocateEvent();
   event->timestamp = GetTimestampNow() + delay;
-  event->callback = callback;
+  event->event_class = event_class;
+  event->user_data = user_data;
+  Link(event);
+  return event;
+}
+
+void Scheduler::Cancel(Event* event) {
+  Unlink(event);
+  FreeEvent(event);
+}
+
+auto Scheduler::Find(EventClass event_class, u64 user_data) -> Event* {
+  Event* result = nullptr;
+
+  ForEachEvent([&](Event* event) {
+    if (result == nullptr && event->event_class == event_class && event->user_data == user_data) {
+      result = event;
+    }
+  });
+
+  return result;
+}
+
+auto Scheduler::Count(EventClass event_class) -> int {
+  int count = 0;
 
-  while (n != 0 && heap[p]->timestamp > heap[n]->timestamp) {
-    Swap(n, p);
-    n = p;
-    p = Parent(n);
+  ForEachEvent([&](Event* event) {
+    if (event->event_class == event_class) {
+      count++;
+    }
+  });
+
+  return count;
+}
+
+void Scheduler::LoadState(StateReader& state) {
+  Reset();
+
+  int count;
+  state.Read(timestamp_now);
+  state.Read(count);
+
+  constexpr size_t kEventSize = sizeof(u64) + sizeof(EventClass) + sizeof(u64);
+
+  state.Check(count >= 0 && size_t(count) <= state.Remaining() / kEventSize, "Scheduler: bad event count in save state.");
+
+  // The wheel must not be later than any of the restored events.
+  std::vector<Event> events(count);
+  timestamp_wheel = timestamp_now;
+
+  for (auto& event : events) {
+    state.Read(event.timestamp);
+    state.Read(event.event_class);
+    state.Read(event.user_data);
+    timestamp_wheel = std::min(timestamp_wheel, event.timestamp);
+    state.Check(event.event_class < EventClass::Count, "Scheduler: bad event class in save state.");
+
+    // Events are handled as soon as they are due, so none of them can be in the past.
+    // The furthest ahead anything is scheduled is a timer overflow at the slowest prescaler (2^26 cycles).
+    state.Check(event.timestamp >= timestamp_now && event.timestamp - timestamp_now <= 0xFFFFFFFF,
+      "Scheduler: bad event timestamp in save state.");
+  }
+
+  // Events are stored in wheel order (level by level, slot by slot), which is not the order
+  // they are due in, so each one is linked into the wheel again based on its timestamp.
+  // Events that are due at the same time keep their stored order, within a slot that is
+  // the order in which they were added.
+  for (auto const& event : events) {
+    auto copy = AllocateEvent();
+    copy->timestamp = event.timestamp;
+    copy->event_class = event.event_class;
+    copy->user_data = event.user_data;
+    Link(copy);
+  }
+}
+
+void Scheduler::SaveState(StateWriter& state) {
+  state.Write(timestamp_now);
+  state.Write(event_count);
+
+  auto write = [&](Event* event) {
+    state.Write(event->timestamp);
+    state.Write(event->event_class);
+    state.Write(event->user_data);
+  };
+
+  if constexpr (gUseTimingWheelScheduler) {
+    ForEachEvent(write);
+  } else {
+    // Store events that are due at the same time in the order they were added, like the wheel does.
+    auto events = heap;
+    std::sort(events.begin(), events.end(), RunsBefore);
+    std::for_each(events.begin(), events.end(), write);
   }
+}
 
+auto Scheduler::AllocateEvent() -> Event* {
+  if (free_list == nullptr) {
+    chunks.push_back(std::make_unique<Event[]>(kChunkSize));
+    for (int i = 0; i < kChunkSize; i++) {
+      FreeEvent(&chunks.back()[i]);
+    }
+  }
+
+  auto event = free_list;
+  free_list = event->next;
   return event;
 }
 
-void Scheduler::Remove(int n) {
-  Swap(n, --heap_size);
+void Scheduler::FreeEvent(Event* event) {
+  event->next = free_list;
+  free_list = event;
+}
+
+void Scheduler::Link(Event* event) {
+  if constexpr (!gUseTimingWheelScheduler) {
+    event->sequence = next_sequence++;
+    event->handle = int(heap.size());
+    heap.push_back(event);
+    SiftUp(event->handle);
+    timestamp_target = heap[0]->timestamp;
+    event_count++;
+    return;
+  }
+
+  auto difference = event->timestamp ^ timestamp_wheel;
+  auto level = difference == 0 ? 0 : HighestSetBit(difference) / kSlotBits;
+  auto index = (event->timestamp >> (level * kSlotBits)) & (kSlotCount - 1);
+  auto& slot = levels[level].slots[index];
+
+  event->level = u8(level);
+  event->slot = u8(index);
+  event->prev = slot.tail;
+  event->next = nullptr;
+
+  if (slot.tail != nullptr) {
+    slot.tail->next = event;
+  } else {
+    slot.head = event;
+  }
+  slot.tail = event;
+
+  levels[level].occupied |= 1ULL << index;
+  timestamp_target = std::min(timestamp_target, event->timestamp);
+  event_count++;
+}
+
+void Scheduler::Unlink(Event* event) {
+  if constexpr (!gUseTimingWheelScheduler) {
+    auto n = event->handle;
+    auto last = int(heap.size()) - 1;
+
+    // Move the last event into the gap and restore the heap property around it.
+    if (n != last) {
+      Swap(n, last);
+      heap.pop_back();
+      auto moved = heap[n];
+      SiftUp(n);
+      SiftDown(moved->handle);
+    } else {
+      heap.pop_back();
+    }
+
+    event_count--;
+    UpdateTarget();
+    return;
+  }
+
+  auto& level = levels[event->level];
+  auto& slot = level.slots[event->slot];
+
+  if (event->prev != nullptr) {
+    event->prev->next = event->next;
+  } else {
+    slot.head = event->next;
+  }
 
-  int p = Parent(n);
-  if (n != 0 && heap[p]->timestamp > heap[n]->timestamp) {
-    do {
-      Swap(n, p);
-      n = p;
-      p = Parent(n);
-    } while (n != 0 && heap[p]->timestamp > heap[n]->timestamp);
+  if (event->next != nullptr) {
+    event->next->prev = event->prev;
   } else {
-    Heapify(n);
+    slot.tail = event->prev;
+  }
+
+  if (slot.head == nullptr) {
+    level.occupied &= ~(1ULL << event->slot);
+  }
+
+  event_count--;
+
+  if (event->timestamp == timestamp_target) {
+    UpdateTarget();
+  }
+}
+
+void Scheduler::Advance(u64 timestamp) {
+  if constexpr (!gUseTimingWheelScheduler) {
+    return;
+  }
+
+  auto difference = timestamp ^ timestamp_wheel;
+  timestamp_wheel = timestamp;
+
+  if (difference == 0) {
+    return;
+  }
+
+  // Events in lower levels than the highest changed slot digit would be due before the new time,
+  // so the only events that change their level are those in the slot that the new time falls into.
+  auto level = HighestSetBit(difference) / kSlotBits;
+  if (level == 0) {
+    return;
+  }
+
+  auto index = (timestamp >> (level * kSlotBits)) & (kSlotCount - 1);
+  auto& slot = levels[level].slots[index];
+  auto event = slot.head;
+
+  if (event == nullptr) {
+    return;
+  }
+
+  slot = {};
+  levels[level].occupied &= ~(1ULL << index);
+
+  // Link() counts the events again.
+  while (event != nullptr) {
+    auto next = event->next;
+    event_count--;
+    Link(event);
+    event = next;
+  }
+}
+
+void Scheduler::UpdateTarget() {
+  timestamp_target = std::numeric_limits<u64>::max();
+
+  if constexpr (!gUseTimingWheelScheduler) {
+    if (!heap.empty()) {
+      timestamp_target = heap[0]->timestamp;
+    }
+    return;
+  }
+
+  // Events in lower levels are always due before events in higher levels,
+  // and within a level lower slots are due before higher slots.
+  for (int level = 0; level < kLevelCount; level++) {
+    auto occupied = levels[level].occupied;
+    if (occupied == 0) {
+      continue;
+    }
+
+    auto index = LowestSetBit(occupied);
+
+    // All events in a level 0 slot are due at the same time, higher level slots cover a time span.
+    if (level == 0) {
+      timestamp_target = (timestamp_wheel & ~u64(kSlotCount - 1)) | index;
+    } else {
+      for (auto event = levels[level].slots[index].head; event != nullptr; event = event->next) {
+        timestamp_target = std::min(timestamp_target, event->timestamp);
+      }
+    }
+    break;
+  }
+}
+
+void Scheduler::SiftUp(int n) {
+  while (n > 0) {
+    auto parent = (n - 1) / 2;
+    if (!RunsBefore(heap[n], heap[parent])) {
+      break;
+    }
+    Swap(n, parent);
+    n = parent;
+  }
+}
+
+void Scheduler::SiftDown(int n) {
+  auto size = int(heap.size());
+
+  while (true) {
+    auto first = n;
+    auto l = n * 2 + 1;
+    auto r = n * 2 + 2;
+
+    if (l < size && RunsBefore(heap[l], heap[first])) first = l;
+    if (r < size && RunsBefore(heap[r], heap[first])) first = r;
+
+    if (first == n) {
+      break;
+    }
+    Swap(n, first);
+    n = first;
   }
 }
 
 void Scheduler::Swap(int i, int j) {
-  auto tmp = heap[i];
-  heap[i] = heap[j];
-  heap[j] = tmp;
+  std::swap(heap[i], heap[j]);
   heap[i]->handle = i;
   heap[j]->handle = j;
 }
 
-void Scheduler::Heapify(int n) {
-  int l = LeftChild(n);
-  int r = RightChild(n);
-
-  if (l < heap_size && heap[l]->timestamp < heap[n]->timestamp) {
-    Swap(l, n);
-    Heapify(l);
+template<typename Functor>
+void Scheduler::ForEachEvent(Functor functor) {
+  if constexpr (!gUseTimingWheelScheduler) {
+    // The functor may recycle the event.
+    auto events = heap;
+    std::for_each(events.begin(), events.end(), functor);
+    return;
   }
 
-  if (r < heap_size && heap[r]->timestamp < heap[n]->timestamp) {
-    Swap(r, n);
-    Heapify(r);
+  for (auto& level : levels) {
+    auto occupied = level.occupied;
+
+    while (occupied != 0) {
+      auto index = LowestSetBit(occupied);
+      occupied &= occupied - 1;
+
+      // The functor may recycle the event.
+      for (auto event = level.slots[index].head; event != nullptr;) {
+        auto next = event->next;
+        functor(event);
+        event = next;
+      }
+    }
   }
 }
 
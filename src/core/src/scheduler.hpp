@@ -4,27 +4,62 @@
 
 #pragma once
 
+#include <buildconfig.hpp>
 #include <util/integer.hpp>
 #include <util/log.hpp>
 #include <functional>
 #include <limits>
+#include <memory>
+#include <vector>
+
+#include "save_state.hpp"
 
 namespace Duality::Core {
 
-/// Manages hardware events in a priority queue based on time (cycles).
+/// Manages hardware events in a hierarchical timing wheel based on time (cycles).
+/// Adding and cancelling an event takes constant time, regardless of how many events are pending.
+/// A binary heap can be selected instead, see gUseTimingWheelScheduler.
 struct Scheduler {
   Scheduler();
  ~Scheduler();
 
+  /// Identifies the handler of an event. Unlike a plain callback this can be
+  /// saved and restored, which is required for save states.
+  /// NOTE: the values are part of the save state format, only append new ones.
+  enum class EventClass : u16 {
+    VideoUnit_HdrawBegin,
+    VideoUnit_HblankBegin,
+    GPU_CommandDone,
+    APU_StepMixer,
+    APU_StepChannel, // unused, the APU generates channel samples in batches
+    ARM7_TimerOverflow,
+    ARM9_TimerOverflow,
+    ARM7_DMA,
+    ARM9_DMA,
+    Count
+  };
+
+  using Callback = std::function<void(int cycles_late, u64 user_data)>;
+
   template<class T>
   using EventMethod = void (T::*)(int);
 
   struct Event {
-    std::function<void(int)> callback;
   private:
     friend class Scheduler;
-    int handle;
     u64 timestamp;
+    EventClass event_class;
+    u64 user_data;
+
+    /// Position in the timing wheel
+    u8 level;
+    u8 slot;
+    Event* prev;
+    Event* next;
+
+    /// Position in the binary heap, and the order in which the events were added.
+    int handle;
+    u64 sequence;
   };
 
   auto GetTimestampNow() const -> u64 {
@@ -32,10 +67,7 @@ struct Scheduler {
   }
 
   auto GetTimestampTarget() const -> u64 {
-    if (heap_size == 0) {
-      return std::numeric_limits<u64>::max();
-    }
-    return heap[0]->timestamp;
+    return timestamp_target;
   }
 
   auto GetRemainingCycleCount() const -> int {
@@ -48,30 +80,85 @@ struct Scheduler {
 
   void Reset();
   void Step();
-  auto Add(u64 delay, std::function<void(int)> callback) -> Event*;
-  void Cancel(Event* event) { Remove(event->handle); }
+  void Register(EventClass event_class, Callback callback);
+  auto Add(u64 delay, EventClass event_class, u64 user_data = 0) -> Event*;
+  void Cancel(Event* event);
 
   template<class T>
-  auto Add(std::uint64_t delay, T* object, EventMethod<T> method) -> Event* {
-    return Add(delay, [object, method](int cycles_late) {
+  void Register(EventClass event_class, T* object, EventMethod<T> method) {
+    Register(event_class, [object, method](int cycles_late, u64) {
       (object->*method)(cycles_late);
     });
   }
 
+  /// Find a pending event, e.g. to recover event handles after loading a save state.
+  auto Find(EventClass event_class, u64 user_data = 0) -> Event*;
+
+  /// Count the pending events of a class, e.g. to validate a save state.
+  auto Count(EventClass event_class) -> int;
+
+  void LoadState(StateReader& state);
+  void SaveState(StateWriter& state);
+
 private:
-  static constexpr int kMaxEvents = 64;
+  /// Each level of the wheel has 64 slots and covers 64 times the time span of the level below.
+  /// Level 0 has one slot per cycle, eleven levels cover the entire 64-bit range.
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlotCount = 1 << kSlotBits;
+  static constexpr int kLevelCount = (64 + kSlotBits - 1) / kSlotBits;
+
+  /// Events are allocated in chunks of this many events, which are never freed.
+  static constexpr int kChunkSize = 64;
+
+  /// Events in a slot are kept in the order they were added,
+  /// so that events due at the same time run in that order.
+  struct Slot {
+    Event* head = nullptr;
+    Event* tail = nullptr;
+  };
+
+  struct Level {
+    u64 occupied = 0;
+    Slot slots[kSlotCount];
+  };
 
-  constexpr int Parent(int n) { return (n - 1) / 2; }
-  constexpr int LeftChild(int n) { return n * 2 + 1; }
-  constexpr int RightChild(int n) { return n * 2 + 2; }
+  auto AllocateEvent() -> Event*;
+  void FreeEvent(Event* event);
+  void Link(Event* event);
+  void Unlink(Event* event);
+  void Advance(u64 timestamp);
+  void UpdateTarget();
 
-  void Remove(int n);
+  static bool RunsBefore(Event const* a, Event const* b) {
+    return a->timestamp < b->timestamp || (a->timestamp == b->timestamp && a->sequence < b->sequence);
+  }
+
+  void SiftUp(int n);
+  void SiftDown(int n);
   void Swap(int i, int j);
-  void Heapify(int n);
 
-  int heap_size;
-  Event* heap[kMaxEvents];
+  template<typename Functor>
+  void ForEachEvent(Functor functor);
+
   u64 timestamp_now;
+  u64 timestamp_target;
+
+  /// Reference time of the wheel: an event is stored in the level of the
+  /// highest slot digit in which its timestamp differs from this time.
+  /// Never later than the current time or any pending event.
+  u64 timestamp_wheel;
+
+  int event_count;
+  Level levels[kLevelCount];
+
+  /// Binary heap, only used without gUseTimingWheelScheduler.
+  std::vector<Event*> heap;
+  u64 next_sequence = 0;
+
+  std::vector<std::unique_ptr<Event[]>> chunks;
+  Event* free_list = nullptr;
+
+  Callback callbacks[static_cast<int>(EventClass::Count)];
 };
 
 } // namespace Duality::Core
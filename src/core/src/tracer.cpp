@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <fmt/format.h>
+#include <fstream>
+#include <util/log.hpp>
+
+#include "scheduler.hpp"
+#include "tracer.hpp"
+
+namespace Duality::Core {
+
+static constexpr const char* kTrackNames[] {
+  "",
+  "Scheduler",
+  "ARM9",
+  "ARM7",
+  "GPU",
+  "PPU"
+};
+
+void Tracer::Start(std::string const& path) {
+  if (recording) {
+    Stop();
+  }
+
+  this->path = path;
+  events.clear();
+  events.reserve(0x10000);
+  host_origin = Now();
+  recording = true;
+
+  LOG_INFO("Tracer: recording trace to {0}", path);
+}
+
+void Tracer::Stop() {
+  if (!recording) {
+    return;
+  }
+
+  recording = false;
+
+  std::ofstream file{path, std::ios::out | std::ios::trunc};
+  if (!file.good()) {
+    LOG_ERROR("Tracer: failed to open {0} for writing", path);
+    return;
+  }
+
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+  for (int i = 1; i < (int)std::size(kTrackNames); i++) {
+    file << fmt::format("{{\"ph\":\"M\",\"pid\":0,\"tid\":{0},\"name\":\"thread_name\",\"args\":{{\"name\":\"{1}\"}}}},\n", i, kTrackNames[i]);
+  }
+
+  for (auto const& event : events) {
+    auto ts = (event.host_start - host_origin) / 1000.0;
+
+    file << fmt::format("{{\"pid\":0,\"tid\":{0},\"name\":\"{1}\",\"ts\":{2:.3f},", int(event.track), event.name, ts);
+    if (event.instant) {
+      file << "\"ph\":\"i\",\"s\":\"t\",";
+    } else {
+      file << fmt::format("\"ph\":\"X\",\"dur\":{0:.3f},", event.host_duration / 1000.0);
+    }
+    file << fmt::format("\"args\":{{\"cycles\":{0}", event.cycles_start);
+    if (!event.instant) {
+      file << fmt::format(",\"cycles_duration\":{0}", event.cycles_duration);
+    }
+    if (event.arg_name != nullptr) {
+      file << fmt::format(",\"{0}\":{1}", event.arg_name, event.arg_value);
+    }
+    file << "}},\n";
+  }
+
+  // Trailing metadata event, so that the list does not end on a comma.
+  file << "{\"ph\":\"M\",\"pid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"Duality\"}}\n]}\n";
+
+  LOG_INFO("Tracer: wrote {0} events to {1}", events.size(), path);
+
+  events.clear();
+  events.shrink_to_fit();
+}
+
+void Tracer::Instant(Track track, const char* name, const char* arg_name, u64 arg_value) {
+  if (recording) {
+    Record({name, arg_name, arg_value, Now(), 0, GetCycles(), 0, track, true});
+  }
+}
+
+auto Tracer::GetCycles() const -> u64 {
+  return scheduler.GetTimestampNow();
+}
+
+void Tracer::Record(Event const& event) {
+  std::lock_guard guard{events_lock};
+
+  if (events.size() < kMaxEvents) {
+    events.push_back(event);
+
+    if (events.size() == kMaxEvents) {
+      LOG_WARN("Tracer: reached event limit, dropping further events.");
+    }
+  }
+}
+
+Tracer::TracedScope::TracedScope(Track track, const char* name, const char* arg_name, u64 arg_value)
+    : track(track), name(name), arg_name(arg_name), arg_value(arg_value), tracer(current) {
+  if (tracer != nullptr && !tracer->recording) {
+    tracer = nullptr;
+  }
+  if (tracer != nullptr) {
+    host_start = Now();
+    cycles_start = tracer->GetCycles();
+  }
+}
+
+Tracer::TracedScope::~TracedScope() {
+  if (tracer != nullptr && tracer->recording) {
+    auto host_end = Now();
+    auto cycles_end = tracer->GetCycles();
+    tracer->Record({
+      name,
+      arg_name,
+      arg_value,
+      host_start,
+      host_end - host_start,
+      cycles_start,
+      cycles_end - cycles_start,
+      track,
+      false
+    });
+  }
+}
+
+} // namespace Duality::Core
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <buildconfig.hpp>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <util/integer.hpp>
+#include <vector>
+
+namespace Duality::Core {
+
+struct Scheduler;
+
+/// Records a timeline of hardware activity and writes it out in the
+/// Chrome trace-event JSON format, which can be loaded into chrome://tracing
+/// or Perfetto. Every event carries the host time and the emulated cycle count.
+/// Everything in here compiles to nothing unless gEnableTracing is set.
+struct Tracer {
+  /// Each track shows up as a separate row in the trace viewer.
+  enum class Track {
+    Scheduler = 1,
+    ARM9 = 2,
+    ARM7 = 3,
+    GPU  = 4,
+    PPU  = 5
+  };
+
+  /// Upper bound for the number of buffered events (roughly 100 MiB).
+  /// Once reached, further events are dropped until the trace is stopped.
+  static constexpr size_t kMaxEvents = 0x200000;
+
+  Tracer(Scheduler const& scheduler) : scheduler(scheduler) {}
+
+  /// The tracer that receives the events recorded on the calling thread, may be null.
+  static auto Current() -> Tracer* { return current; }
+
+  /// RAII helper that directs the events recorded on the calling thread to a tracer.
+  struct Bind {
+    Bind(Tracer& tracer) {
+      if constexpr (gEnableTracing) {
+        previous = current;
+        current = &tracer;
+      }
+    }
+
+   ~Bind() {
+      if constexpr (gEnableTracing) {
+        current = previous;
+      }
+    }
+
+  private:
+    Tracer* previous = nullptr;
+  };
+
+  static auto Now() -> u64 {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  bool IsRecording() const { return recording; }
+
+  /// Must not be called while the core is running.
+  void Start(std::string const& path);
+  void Stop();
+
+  void Instant(Track track, const char* name, const char* arg_name = nullptr, u64 arg_value = 0);
+
+  /// RAII helper that records its lifetime as a complete (duration) event.
+  /// The name and argument name must be string literals.
+  struct TracedScope {
+    TracedScope(Track track, const char* name, const char* arg_name = nullptr, u64 arg_value = 0);
+   ~TracedScope();
+
+  private:
+    Track track;
+    const char* name;
+    const char* arg_name;
+    u64 arg_value;
+    u64 host_start;
+    u64 cycles_start;
+    Tracer* tracer;
+  };
+
+  struct NullScope {
+    constexpr NullScope(Track, const char*, const char* = nullptr, u64 = 0) {}
+  };
+
+  using Scope = std::conditional_t<gEnableTracing, TracedScope, NullScope>;
+
+private:
+  struct Event {
+    const char* name;
+    const char* arg_name;
+    u64 arg_value;
+    u64 host_start;
+    u64 host_duration;
+    u64 cycles_start;
+    u64 cycles_duration;
+    Track track;
+    bool instant;
+  };
+
+  auto GetCycles() const -> u64;
+  void Record(Event const& event);
+
+  static inline thread_local Tracer* current = nullptr;
+
+  bool recording = false;
+  std::string path;
+  u64 host_origin = 0;
+  Scheduler const& scheduler;
+
+  /// The ARM7 thread may record events at the same time as the ARM9 thread.
+  std::mutex events_lock;
+  std::vector<Event> events;
+};
+
+} // namespace Duality::Core
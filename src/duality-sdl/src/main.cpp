@@ -45,8 +45,11 @@ void loop(Duality::Core::Core& core) {
   int frames = 0;
   auto t0 = SDL_GetTicks();
   SDL_Event event;
+  bool tracing = false;
+  std::vector<u8> quicksave;
 
   auto emu_thread = Duality::EmulatorThread{core};
+  emu_thread.SetRewindEnabled(true);
   emu_thread.Start();
 
   for (;;) {
@@ -80,6 +83,37 @@ void loop(Duality::Core::Core& core) {
           case SDLK_q: input_device.SetKeyDown(Key::X, down); break;
           case SDLK_w: input_device.SetKeyDown(Key::Y, down); break;
           case SDLK_SPACE: emu_thread.SetFastForward(down); break;
+          case SDLK_BACKSPACE: emu_thread.SetRewinding(down); break;
+          case SDLK_F10: {
+            if (down && event.key.repeat == 0) {
+              // The core must not be running while the trace is started or written.
+              emu_thread.Stop();
+              if (tracing) {
+                core.StopTrace();
+              } else {
+                core.StartTrace("trace.json");
+              }
+              tracing = !tracing;
+              emu_thread.Start();
+            }
+            break;
+          }
+          case SDLK_F5: {
+            if (down && event.key.repeat == 0) {
+              emu_thread.Stop();
+              core.SaveState(quicksave);
+              emu_thread.Start();
+            }
+            break;
+          }
+          case SDLK_F7: {
+            if (down && event.key.repeat == 0 && !quicksave.empty()) {
+              emu_thread.Stop();
+              core.LoadState(quicksave);
+              emu_thread.Start();
+            }
+            break;
+          }
         }
       }
 
@@ -97,6 +131,9 @@ void loop(Duality::Core::Core& core) {
 
 cleanup:
   emu_thread.Stop();
+  if (tracing) {
+    core.StopTrace();
+  }
   SDL_GL_DeleteContext(gl_context);
   SDL_DestroyWindow(window);
 }
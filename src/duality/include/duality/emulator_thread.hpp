@@ -7,6 +7,7 @@
 #include <atomic>
 #include <core/core.hpp>
 #include <duality/frame_limiter.hpp>
+#include <duality/rewind_buffer.hpp>
 #include <thread>
 
 namespace Duality {
@@ -18,6 +19,14 @@ struct EmulatorThread {
   bool IsRunning() const;
   auto GetFPS() const -> float;
   void SetFastForward(bool enabled);
+
+  /// Record a state every frame, so that emulation can be rewound.
+  /// Disabling rewind discards the recorded history.
+  void SetRewindEnabled(bool enabled);
+
+  /// While set, the emulator steps backwards through the history instead of advancing.
+  void SetRewinding(bool rewinding);
+
   void Start();
   void Stop();
 
@@ -25,6 +34,9 @@ private:
   float fps = 0.0;
   Core::Core& core;
   FrameLimiter frame_limiter;
+  RewindBuffer rewind_buffer;
+  std::atomic_bool rewind_enabled = false;
+  std::atomic_bool rewinding = false;
 
   std::thread thread;
   std::atomic_bool running = false;
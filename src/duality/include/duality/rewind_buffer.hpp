@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <core/core.hpp>
+#include <deque>
+#include <util/integer.hpp>
+#include <vector>
+
+namespace Duality {
+
+/// Keeps a history of recent emulator states, so that emulation can be stepped backwards.
+/// Every frame an incremental save state (only the memory pages that changed)
+/// is taken and LZ-compressed. A full keyframe is stored at a fixed interval,
+/// so that the oldest history can be dropped once the memory budget is exceeded.
+/// Must only be used while the core is not running.
+struct RewindBuffer {
+  /// Default memory budget, enough for several seconds of history.
+  static constexpr size_t kDefaultBudget = 64 * 1024 * 1024;
+
+  /// Number of frames between two keyframes.
+  /// Restoring a state replays at most this many incremental states.
+  static constexpr int kKeyframeInterval = 60;
+
+  RewindBuffer(Core::Core& core, size_t budget = kDefaultBudget);
+
+  void SetBudget(size_t budget);
+  void Clear();
+
+  /// Record the current state of the core.
+  void Push();
+
+  /// Discard the most recent state and restore the one before it.
+  /// Returns false if there is no older state to go back to.
+  bool Pop();
+
+  bool IsEmpty() const { return snapshots.empty(); }
+  auto GetLength() const -> size_t { return snapshots.size(); }
+  auto GetMemoryUsage() const -> size_t { return memory_usage; }
+
+private:
+  struct Snapshot {
+    std::vector<u8> data;
+    bool keyframe;
+  };
+
+  void Restore(size_t index);
+  void DropOldest();
+
+  Core::Core& core;
+  size_t budget;
+  size_t memory_usage = 0;
+  int keyframe_count = 0;
+  int frames_since_keyframe = 0;
+  std::deque<Snapshot> snapshots;
+
+  /// Scratch buffers, kept around to avoid reallocating them every frame.
+  std::vector<u8> state;
+  std::vector<u8> compressed;
+
+  /// The most recently restored keyframe, decompressed.
+  /// Rewinding several frames in a row restores from the same keyframe each time.
+  Snapshot const* cached_keyframe = nullptr;
+  std::vector<u8> keyframe_state;
+};
+
+} // namespace Duality
@@ -7,7 +7,8 @@
 namespace Duality {
 
 EmulatorThread::EmulatorThread(Duality::Core::Core& core)
-    : core(core) {
+    : core(core)
+    , rewind_buffer(core) {
   frame_limiter.Reset(59.8983);
 }
 
@@ -28,6 +29,14 @@ void EmulatorThread::SetFastForward(bool enabled) {
   frame_limiter.SetFastForward(enabled);
 }
 
+void EmulatorThread::SetRewindEnabled(bool enabled) {
+  rewind_enabled = enabled;
+}
+
+void EmulatorThread::SetRewinding(bool rewinding) {
+  this->rewinding = rewinding;
+}
+
 void EmulatorThread::Start() {
   if (running) {
     return;
@@ -41,7 +50,20 @@ void EmulatorThread::Start() {
 
     while (running) {
       frame_limiter.Run([this]() {
-        core.Run(kCyclesPerFrame);
+        if (!rewind_enabled) {
+          if (!rewind_buffer.IsEmpty()) {
+            rewind_buffer.Clear();
+          }
+          core.Run(kCyclesPerFrame);
+        } else if (rewinding) {
+          // Run the restored state for one frame (without recording it), so that it gets displayed.
+          if (rewind_buffer.Pop()) {
+            core.Run(kCyclesPerFrame);
+          }
+        } else {
+          core.Run(kCyclesPerFrame);
+          rewind_buffer.Push();
+        }
       }, [this](float fps) {
         this->fps = fps;
       });
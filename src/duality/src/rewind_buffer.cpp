@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <duality/rewind_buffer.hpp>
+#include <util/log.hpp>
+#include <util/lz.hpp>
+
+namespace Duality {
+
+RewindBuffer::RewindBuffer(Core::Core& core, size_t budget)
+    : core(core)
+    , budget(budget) {
+}
+
+void RewindBuffer::SetBudget(size_t budget) {
+  this->budget = budget;
+  while (memory_usage > budget && keyframe_count > 1) {
+    DropOldest();
+  }
+}
+
+void RewindBuffer::Clear() {
+  snapshots.clear();
+  cached_keyframe = nullptr;
+  memory_usage = 0;
+  keyframe_count = 0;
+  frames_since_keyframe = 0;
+}
+
+void RewindBuffer::Push() {
+  // The history must always begin with a keyframe.
+  bool keyframe = snapshots.empty() || frames_since_keyframe >= kKeyframeInterval;
+
+  if (keyframe) {
+    core.SaveState(state);
+    keyframe_count++;
+    frames_since_keyframe = 0;
+  } else {
+    core.SaveStateIncremental(state);
+  }
+  frames_since_keyframe++;
+
+  compressed.clear();
+  common::LZ::Compress(state.data(), state.size(), compressed);
+
+  snapshots.push_back({{compressed.begin(), compressed.end()}, keyframe});
+  memory_usage += compressed.size();
+
+  // Keep at least one keyframe interval around, even if it exceeds the budget.
+  while (memory_usage > budget && keyframe_count > 1) {
+    DropOldest();
+  }
+}
+
+bool RewindBuffer::Pop() {
+  if (snapshots.size() < 2) {
+    return false;
+  }
+
+  if (snapshots.back().keyframe) {
+    keyframe_count--;
+  }
+  if (&snapshots.back() == cached_keyframe) {
+    cached_keyframe = nullptr;
+  }
+  memory_usage -= snapshots.back().data.size();
+  snapshots.pop_back();
+  Restore(snapshots.size() - 1);
+
+  // The restored state does not match the last incremental state anymore,
+  // so continue the history with a keyframe.
+  frames_since_keyframe = kKeyframeInterval;
+  return true;
+}
+
+void RewindBuffer::Restore(size_t index) {
+  auto keyframe = index;
+  while (!snapshots[keyframe].keyframe) {
+    keyframe--;
+  }
+
+  // The history was recorded by this core, so the states are loaded without a rollback copy.
+  bool success = true;
+
+  if (&snapshots[keyframe] != cached_keyframe) {
+    auto const& data = snapshots[keyframe].data;
+    cached_keyframe = nullptr;
+    success = common::LZ::Decompress(data.data(), data.size(), keyframe_state);
+    if (success) {
+      cached_keyframe = &snapshots[keyframe];
+    }
+  }
+  success = success && core.LoadStateTrusted(keyframe_state);
+
+  for (auto i = keyframe + 1; success && i <= index; i++) {
+    auto const& data = snapshots[i].data;
+    success = common::LZ::Decompress(data.data(), data.size(), state) && core.LoadStateTrusted(state);
+  }
+
+  if (!success) {
+    LOG_ERROR("RewindBuffer: failed to restore state, discarding history.");
+    Clear();
+  }
+}
+
+void RewindBuffer::DropOldest() {
+  // Incremental states cannot be restored without their keyframe,
+  // so the complete interval up to the next keyframe is dropped.
+  keyframe_count--;
+  do {
+    if (&snapshots.front() == cached_keyframe) {
+      cached_keyframe = nullptr;
+    }
+    memory_usage -= snapshots.front().data.size();
+    snapshots.pop_front();
+  } while (!snapshots.empty() && !snapshots.front().keyframe);
+}
+
+} // namespace Duality
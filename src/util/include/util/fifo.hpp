@@ -29,6 +29,11 @@ struct FIFO {
   bool IsEmpty() { return count == 0; }
   bool IsFull() { return count == size; }
 
+  /// Whether the read and write positions agree with the count, e.g. after restoring a save state.
+  bool IsValid() const {
+    return rd_ptr < size && wr_ptr < size && count <= size && (rd_ptr + count) % size == wr_ptr;
+  }
+
   auto Peek() -> T {
     return data[rd_ptr];
   }
@@ -1,12 +1,13 @@
-/* 
+/*
  * Copyright (C) 2020 fleroviux
- * 
+ *
  * Licensed under GPLv3 or any later version.
  * Refer to the included LICENSE file.
  */
 
 #pragma once
 
+#include <atomic>
 #include <buildconfig.hpp>
 #include <cstdlib>
 #include <string>
@@ -23,30 +24,45 @@ enum class Level {
   Fatal
 };
 
+namespace detail {
+
+inline std::atomic<Level> g_level{Level(gMinimumLogLevel)};
+
+} // namespace common::logger::detail
+
+/// Messages below the given level are dropped at runtime, before they are formatted.
+/// Levels below gMinimumLogLevel are compiled out regardless.
+inline void set_level(Level level) {
+  detail::g_level.store(level, std::memory_order_relaxed);
+}
+
+inline bool is_enabled(Level level) {
+  return level >= detail::g_level.load(std::memory_order_relaxed);
+}
+
+/// Queue a message for output. This never blocks,
+/// the message is printed by a background thread.
+/// Fatal messages are the exception, they are printed before returning.
 void append(Level level,
             const char* file,
             int line,
             std::string const& message);
 
-#define LOG_TRACE(message, ...) if (gEnableLogging) common::logger::append(common::logger::Level::Trace, __FILE__, __LINE__, \
-                                                       fmt::format(message, ## __VA_ARGS__));
-
-#define LOG_DEBUG(message, ...) if (gEnableLogging) common::logger::append(common::logger::Level::Debug, __FILE__, __LINE__, \
-                                                       fmt::format(message, ## __VA_ARGS__));
-
-#define LOG_INFO(message, ...) if (gEnableLogging) common::logger::append(common::logger::Level::Info, __FILE__, __LINE__, \
-                                                      fmt::format(message, ## __VA_ARGS__));
-
-#define LOG_WARN(message, ...) if (gEnableLogging) common::logger::append(common::logger::Level::Warn, __FILE__, __LINE__, \
-                                                      fmt::format(message, ## __VA_ARGS__));
+/// Block until all queued messages have been printed.
+void flush();
 
-#define LOG_ERROR(message, ...) if (gEnableLogging) common::logger::append(common::logger::Level::Error, __FILE__, __LINE__, \
-                                                       fmt::format(message, ## __VA_ARGS__));
+#define LOG_IMPL(level, message, ...) if constexpr (gEnableLogging && int(level) >= gMinimumLogLevel) { \
+                                        if (common::logger::is_enabled(level)) common::logger::append(level, __FILE__, __LINE__, \
+                                                       fmt::format(message, ## __VA_ARGS__)); }
 
-#define LOG_FATAL(message, ...) if (gEnableLogging) common::logger::append(logger::detail::Level::Fatal, __FILE__, __LINE__, \
-                                                       fmt::format(message, ## __VA_ARGS__));
+#define LOG_TRACE(message, ...) LOG_IMPL(common::logger::Level::Trace, message, ## __VA_ARGS__)
+#define LOG_DEBUG(message, ...) LOG_IMPL(common::logger::Level::Debug, message, ## __VA_ARGS__)
+#define LOG_INFO(message, ...)  LOG_IMPL(common::logger::Level::Info,  message, ## __VA_ARGS__)
+#define LOG_WARN(message, ...)  LOG_IMPL(common::logger::Level::Warn,  message, ## __VA_ARGS__)
+#define LOG_ERROR(message, ...) LOG_IMPL(common::logger::Level::Error, message, ## __VA_ARGS__)
+#define LOG_FATAL(message, ...) LOG_IMPL(common::logger::Level::Fatal, message, ## __VA_ARGS__)
 
-#define ASSERT(condition, message, ...) if (gEnableLogging && !(condition)) { LOG_ERROR(message, ## __VA_ARGS__); std::exit(-1); }
+#define ASSERT(condition, message, ...) if (gEnableLogging && !(condition)) { LOG_FATAL(message, ## __VA_ARGS__); std::exit(-1); }
 
 #define UNREACHABLE ASSERT(false, "reached supposedly unreachable code.");
 
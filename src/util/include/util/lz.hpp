@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <util/integer.hpp>
+#include <vector>
+
+namespace common {
+
+/// Small and fast LZ77 compressor in the spirit of LZ4.
+/// It trades compression ratio for speed, which makes it suitable for
+/// compressing save states every frame. The stream begins with the
+/// uncompressed size, so that Decompress() can size its output up-front.
+namespace LZ {
+
+/// Compress data and append the result to dst.
+void Compress(u8 const* src, size_t size, std::vector<u8>& dst);
+
+/// Decompress a stream created by Compress() into dst (replacing its contents).
+/// Returns false if the stream is malformed.
+bool Decompress(u8 const* src, size_t size, std::vector<u8>& dst);
+
+} // namespace common::LZ
+
+} // namespace common
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <util/integer.hpp>
+#include <vector>
+
+namespace common {
+
+/// View of a file's contents.
+/// The file is memory-mapped where the host supports it, otherwise
+/// it is read into a buffer once. In both cases Data() stays valid
+/// until the file is closed.
+/// Files opened with OpenWritable() are mapped shared, so that modifications
+/// end up in the file. Flush() forces them to disk (or writes the buffer back).
+struct MappedFile {
+  MappedFile() = default;
+  MappedFile(MappedFile const&) = delete;
+ ~MappedFile() { Close(); }
+
+  auto operator=(MappedFile const&) -> MappedFile& = delete;
+
+  bool Open(std::string const& path);
+
+  /// Open a file for reading and writing. The file is created if it does
+  /// not exist and resized to the given size (new bytes are zero).
+  bool OpenWritable(std::string const& path, size_t size);
+  void Close();
+
+  bool IsOpen() const { return is_open; }
+  bool IsMapped() const { return mapped; }
+  bool IsWritable() const { return writable; }
+
+  auto Data() const -> u8 const* { return data; }
+  auto MutableData() -> u8* { return writable ? data : nullptr; }
+  auto Size() const -> size_t { return size; }
+
+  /// Write back a modified range of a writable file. This blocks until the data is on disk.
+  bool Flush(size_t offset, size_t length);
+
+private:
+  bool is_open = false;
+  bool mapped = false;
+  bool writable = false;
+  u8* data = nullptr;
+  size_t size = 0;
+  std::string path;
+  std::vector<u8> buffer;
+};
+
+} // namespace common
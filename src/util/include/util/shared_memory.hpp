@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <util/integer.hpp>
+
+namespace common {
+
+/// Fixed-size pool of zero-initialized, page-aligned host memory.
+/// Where the host supports it, the pool is backed by an anonymous shared memory
+/// file, so that any part of it can be mapped again at other addresses (see GetFile()).
+/// Otherwise it is a plain allocation and IsShared() returns false.
+struct SharedMemory {
+  static constexpr size_t kPageSize = 4096;
+
+  SharedMemory(size_t capacity);
+  SharedMemory(SharedMemory const&) = delete;
+ ~SharedMemory();
+
+  auto operator=(SharedMemory const&) -> SharedMemory& = delete;
+
+  /// Allocate `size` bytes, rounded up to a multiple of the page size.
+  /// The memory is owned by the pool and lives as long as it does.
+  auto Allocate(size_t size) -> u8*;
+
+  template<typename T>
+  auto Allocate() -> T& {
+    return *new (Allocate(sizeof(T))) T;
+  }
+
+  bool IsShared() const { return fd != -1; }
+
+  /// File descriptor of the backing file, or -1 if the pool is not shared.
+  auto GetFile() const -> int { return fd; }
+
+  /// Get the offset of a host address into the backing file.
+  /// Returns false if the address is not part of the pool.
+  bool GetOffset(void const* address, size_t& offset) const {
+    auto byte = static_cast<u8 const*>(address);
+    if (byte < data || byte >= data + used) {
+      return false;
+    }
+    offset = byte - data;
+    return true;
+  }
+
+private:
+  int fd = -1;
+  u8* data = nullptr;
+  size_t capacity;
+  size_t used = 0;
+  std::unique_ptr<u8[]> buffer;
+};
+
+} // namespace common
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace common {
+
+/// Lock-free ring buffer for exactly one producer and one consumer thread.
+/// Write() must only be called by the producer, Read() only by the consumer.
+template <typename T, std::size_t size>
+struct SPSCRing {
+  static_assert((size & (size - 1)) == 0, "SPSCRing: size must be a power of two");
+
+  /// Number of elements that can be read. From the producer's
+  /// point of view this may be less than the real value.
+  auto Count() const -> std::size_t {
+    return wr_pos.load(std::memory_order_acquire) - rd_pos.load(std::memory_order_acquire);
+  }
+
+  /// Write up to `count` elements, returns how many were written.
+  auto Write(T const* data, std::size_t count) -> std::size_t {
+    auto wr = wr_pos.load(std::memory_order_relaxed);
+    auto rd = rd_pos.load(std::memory_order_acquire);
+
+    if (count > size - (wr - rd)) {
+      count = size - (wr - rd);
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+      buffer[(wr + i) & (size - 1)] = data[i];
+    }
+
+    wr_pos.store(wr + count, std::memory_order_release);
+    return count;
+  }
+
+  /// Read up to `count` elements, returns how many were read.
+  auto Read(T* data, std::size_t count) -> std::size_t {
+    auto rd = rd_pos.load(std::memory_order_relaxed);
+    auto wr = wr_pos.load(std::memory_order_acquire);
+
+    if (count > wr - rd) {
+      count = wr - rd;
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+      data[i] = buffer[(rd + i) & (size - 1)];
+    }
+
+    rd_pos.store(rd + count, std::memory_order_release);
+    return count;
+  }
+
+  /// Drop up to `count` elements without reading them, returns how many were dropped.
+  /// Must only be called by the consumer.
+  auto Discard(std::size_t count) -> std::size_t {
+    auto rd = rd_pos.load(std::memory_order_relaxed);
+    auto wr = wr_pos.load(std::memory_order_acquire);
+
+    if (count > wr - rd) {
+      count = wr - rd;
+    }
+
+    rd_pos.store(rd + count, std::memory_order_release);
+    return count;
+  }
+
+private:
+  // The positions only ever increase and wrap around at the end of std::size_t.
+  // Each one is only written by one side, keep them on separate cache lines.
+  alignas(64) std::atomic<std::size_t> wr_pos = 0;
+  alignas(64) std::atomic<std::size_t> rd_pos = 0;
+  alignas(64) T buffer[size];
+};
+
+} // namespace common
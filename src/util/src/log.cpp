@@ -5,6 +5,10 @@
  * Refer to the included LICENSE file.
  */
 
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <thread>
 #include <util/log.hpp>
 
 namespace common::logger {
@@ -22,10 +26,7 @@ auto trim_filepath(const char* file) -> std::string {
   return tmp.substr(pos);
 }
 
-void append(Level level,
-            const char* file,
-            int line,
-            std::string const& message) {
+static void print(Level level, const char* file, int line, std::string const& message) {
   std::string prefix;
 
   switch (level) {
@@ -52,5 +53,146 @@ void append(Level level,
   fmt::print("{0} {1}:{2}: {3}\e[39m\n", prefix, trim_filepath(file), line, message);
 }
 
-} // namespace common::logger
+namespace {
+
+/// Set once the sink has been destroyed during program exit.
+/// Messages logged afterwards (e.g. from other static destructors) are printed directly.
+std::atomic<bool> g_sink_destroyed{false};
+
+/// Bounded multi-producer queue of pending messages, drained by a background thread.
+/// Every slot carries a sequence number which tells producers and the consumer
+/// whose turn it is, so that neither side ever has to take a lock.
+/// When the queue is full messages are dropped instead of blocking the caller.
+struct Sink {
+  static constexpr size_t kCapacity = 1024;
+
+  Sink() {
+    for (size_t i = 0; i < kCapacity; i++) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    thread = std::thread{[this]() { ThreadMain(); }};
+  }
+
+ ~Sink() {
+    quit.store(true, std::memory_order_release);
+    thread.join();
+    g_sink_destroyed.store(true, std::memory_order_release);
+  }
+
+  void Push(Level level, const char* file, int line, std::string const& message) {
+    auto position = write_position.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    while (true) {
+      slot = &slots[position % kCapacity];
+
+      auto sequence = slot->sequence.load(std::memory_order_acquire);
+      auto difference = intptr_t(sequence) - intptr_t(position);
+
+      if (difference == 0) {
+        if (write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      } else {
+        position = write_position.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->level = level;
+    slot->file = file;
+    slot->line = line;
+    slot->message = message;
+    slot->sequence.store(position + 1, std::memory_order_release);
+  }
+
+  /// Print all messages that were queued before the call.
+  void Drain() {
+    auto target = write_position.load(std::memory_order_acquire);
+
+    while (true) {
+      auto position = read_position.load(std::memory_order_relaxed);
+      if (position >= target) {
+        break;
+      }
+
+      auto& slot = slots[position % kCapacity];
+      if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+        // The producer has claimed the slot, but not finished writing it yet.
+        std::this_thread::yield();
+        continue;
+      }
+
+      // flush() may race with the background thread, only one of them gets to print the slot.
+      if (!read_position.compare_exchange_strong(position, position + 1, std::memory_order_relaxed)) {
+        continue;
+      }
 
+      print(slot.level, slot.file, slot.line, slot.message);
+      slot.sequence.store(position + kCapacity, std::memory_order_release);
+    }
+
+    auto dropped_count = dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped_count != 0) {
+      print(Level::Warn, __FILE__, __LINE__, fmt::format("Log: dropped {0} messages.", dropped_count));
+    }
+  }
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    Level level;
+    const char* file;
+    int line;
+    std::string message;
+  };
+
+  void ThreadMain() {
+    while (!quit.load(std::memory_order_acquire)) {
+      Drain();
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    Drain();
+  }
+
+  std::array<Slot, kCapacity> slots;
+  std::atomic<size_t> write_position{0};
+  std::atomic<size_t> read_position{0};
+  std::atomic<size_t> dropped{0};
+  std::atomic<bool> quit{false};
+  std::thread thread;
+};
+
+auto get_sink() -> Sink& {
+  static Sink sink;
+  return sink;
+}
+
+} // anonymous namespace
+
+void append(Level level,
+            const char* file,
+            int line,
+            std::string const& message) {
+  if (level == Level::Fatal) {
+    // Fatal messages are usually followed by std::exit(), so they must not be
+    // dropped or left in the queue. Print them after everything queued before.
+    flush();
+    print(level, file, line, message);
+    std::fflush(stdout);
+  } else if (g_sink_destroyed.load(std::memory_order_acquire)) {
+    print(level, file, line, message);
+  } else {
+    get_sink().Push(level, file, line, message);
+  }
+}
+
+void flush() {
+  if (!g_sink_destroyed.load(std::memory_order_acquire)) {
+    get_sink().Drain();
+  }
+}
+
+} // namespace common::logger
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <algorithm>
+#include <string.h>
+#include <util/lz.hpp>
+
+/* Stream format:
+ *   u32 uncompressed size
+ *   sequence*
+ *
+ * Each sequence consists of:
+ *   token:    high nibble = literal count, low nibble = match length - kMinMatch
+ *             (a nibble of 15 is followed by extra length bytes, 255 meaning "more follows")
+ *   literals: raw bytes
+ *   offset:   u16 distance back into the output (omitted in the final sequence)
+ */
+
+namespace common::LZ {
+
+static constexpr int kMinMatch = 4;
+static constexpr int kHashBits = 14;
+static constexpr size_t kMaxOffset = 0xFFFF;
+
+static auto Read32(u8 const* data) -> u32 {
+  u32 value;
+  memcpy(&value, data, sizeof(u32));
+  return value;
+}
+
+static auto Hash(u32 value) -> u32 {
+  return (value * 2654435761U) >> (32 - kHashBits);
+}
+
+static void WriteLength(std::vector<u8>& dst, size_t length) {
+  while (length >= 255) {
+    dst.push_back(255);
+    length -= 255;
+  }
+  dst.push_back(u8(length));
+}
+
+static void WriteSequence(std::vector<u8>& dst, u8 const* literals, size_t literal_count, size_t offset, size_t match_length) {
+  auto match_code = match_length >= kMinMatch ? match_length - kMinMatch : 0;
+
+  dst.push_back(u8((std::min<size_t>(literal_count, 15) << 4) | std::min<size_t>(match_code, 15)));
+  if (literal_count >= 15) {
+    WriteLength(dst, literal_count - 15);
+  }
+  dst.insert(dst.end(), literals, literals + literal_count);
+
+  if (match_length != 0) {
+    dst.push_back(u8(offset));
+    dst.push_back(u8(offset >> 8));
+    if (match_code >= 15) {
+      WriteLength(dst, match_code - 15);
+    }
+  }
+}
+
+void Compress(u8 const* src, size_t size, std::vector<u8>& dst) {
+  u32 table[1 << kHashBits];
+  memset(table, 0xFF, sizeof(table));
+
+  dst.reserve(dst.size() + size / 2 + 16);
+  for (int i = 0; i < 4; i++) dst.push_back(u8(size >> (i * 8)));
+
+  size_t position = 0;
+  size_t anchor = 0;
+  size_t misses = 0;
+
+  while (size >= kMinMatch && position <= size - kMinMatch) {
+    auto value = Read32(&src[position]);
+    auto& entry = table[Hash(value)];
+    auto candidate = entry;
+    entry = u32(position);
+
+    if (candidate == 0xFFFFFFFF || position - candidate > kMaxOffset || Read32(&src[candidate]) != value) {
+      // Skip ahead faster through data that does not compress.
+      position += 1 + (misses++ >> 6);
+      continue;
+    }
+
+    auto match_length = size_t(kMinMatch);
+    while (position + match_length < size && src[candidate + match_length] == src[position + match_length]) {
+      match_length++;
+    }
+
+    WriteSequence(dst, &src[anchor], position - anchor, position - candidate, match_length);
+    position += match_length;
+    anchor = position;
+    misses = 0;
+  }
+
+  WriteSequence(dst, &src[anchor], size - anchor, 0, 0);
+}
+
+bool Decompress(u8 const* src, size_t size, std::vector<u8>& dst) {
+  if (size < 4) {
+    return false;
+  }
+
+  size_t output_size = src[0] | (src[1] << 8) | (src[2] << 16) | (size_t(src[3]) << 24);
+  dst.resize(output_size);
+
+  auto src_end = src + size;
+  auto out = dst.data();
+  auto out_end = out + output_size;
+
+  auto read_length = [&](size_t length) -> size_t {
+    if (length == 15) {
+      u8 byte;
+      do {
+        if (src == src_end) return ~size_t(0);
+        byte = *src++;
+        length += byte;
+      } while (byte == 255);
+    }
+    return length;
+  };
+
+  src += 4;
+
+  while (src < src_end) {
+    auto token = *src++;
+
+    auto literal_count = read_length(token >> 4);
+    if (literal_count > size_t(src_end - src) || literal_count > size_t(out_end - out)) {
+      return false;
+    }
+    if (literal_count != 0) {
+      memcpy(out, src, literal_count);
+    }
+    out += literal_count;
+    src += literal_count;
+
+    // The final sequence does not contain a match.
+    if (src == src_end) {
+      break;
+    }
+
+    if (src_end - src < 2) {
+      return false;
+    }
+    size_t offset = src[0] | (src[1] << 8);
+    src += 2;
+
+    auto match_length = read_length(token & 15);
+    if (match_length == ~size_t(0)) {
+      return false;
+    }
+    match_length += kMinMatch;
+
+    if (offset == 0 || offset > size_t(out - dst.data()) || match_length > size_t(out_end - out)) {
+      return false;
+    }
+
+    // Matches may overlap with the bytes that they produce.
+    auto match = out - offset;
+    if (offset >= match_length) {
+      memcpy(out, match, match_length);
+      out += match_length;
+    } else {
+      for (size_t i = 0; i < match_length; i++) *out++ = *match++;
+    }
+  }
+
+  return out == out_end;
+}
+
+} // namespace common::LZ
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <util/mapped_file.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #define HAVE_MMAP
+#endif
+
+namespace common {
+
+bool MappedFile::Open(std::string const& path) {
+  Close();
+
+#ifdef HAVE_MMAP
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd != -1) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* address = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address != MAP_FAILED) {
+        madvise(address, st.st_size, MADV_WILLNEED);
+        data = static_cast<u8*>(address);
+        size = st.st_size;
+        mapped = true;
+        is_open = true;
+      }
+    }
+    // The mapping stays valid after the descriptor has been closed.
+    close(fd);
+
+    if (mapped) {
+      return true;
+    }
+  }
+#endif
+
+  // Fallback: read the whole file into memory.
+  std::ifstream file{path, std::ios::in | std::ios::binary};
+  if (!file.good()) {
+    return false;
+  }
+
+  file.seekg(0, std::ios::end);
+  buffer.resize(file.tellg());
+  file.seekg(0);
+  file.read((char*)buffer.data(), buffer.size());
+  if (!file.good()) {
+    buffer.clear();
+    return false;
+  }
+
+  data = buffer.data();
+  size = buffer.size();
+  is_open = true;
+  return true;
+}
+
+bool MappedFile::OpenWritable(std::string const& path, size_t size) {
+  Close();
+
+  if (size == 0) {
+    return false;
+  }
+
+#ifdef HAVE_MMAP
+  int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat st;
+  bool ok = fstat(fd, &st) == 0 && (size_t(st.st_size) == size || ftruncate(fd, size) == 0);
+  if (ok) {
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address != MAP_FAILED) {
+      data = static_cast<u8*>(address);
+      this->size = size;
+      mapped = true;
+      writable = true;
+      is_open = true;
+    }
+  }
+  close(fd);
+  return is_open;
+#else
+  // Fallback: keep the file contents in memory and write back on Flush().
+  buffer.resize(size);
+
+  std::ifstream file{path, std::ios::in | std::ios::binary};
+  if (file.good()) {
+    file.read((char*)buffer.data(), size);
+  }
+
+  std::ofstream out{path, std::ios::out | std::ios::binary | std::ios::trunc};
+  out.write((char*)buffer.data(), size);
+  if (!out.good()) {
+    buffer.clear();
+    return false;
+  }
+
+  data = buffer.data();
+  this->size = size;
+  this->path = path;
+  writable = true;
+  is_open = true;
+  return true;
+#endif
+}
+
+bool MappedFile::Flush(size_t offset, size_t length) {
+  if (!writable || offset >= size) {
+    return false;
+  }
+
+  length = std::min(length, size - offset);
+
+#ifdef HAVE_MMAP
+  if (mapped) {
+    // msync() requires a page-aligned start address.
+    auto page_size = size_t(sysconf(_SC_PAGESIZE));
+    auto aligned_offset = offset & ~(page_size - 1);
+    return msync(data + aligned_offset, length + offset - aligned_offset, MS_SYNC) == 0;
+  }
+#endif
+
+  std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+  file.seekp(offset);
+  file.write((char*)data + offset, length);
+  return file.good();
+}
+
+void MappedFile::Close() {
+#ifdef HAVE_MMAP
+  if (mapped) {
+    munmap(data, size);
+  }
+#endif
+
+  buffer.clear();
+  buffer.shrink_to_fit();
+  data = nullptr;
+  size = 0;
+  path.clear();
+  mapped = false;
+  writable = false;
+  is_open = false;
+}
+
+} // namespace common
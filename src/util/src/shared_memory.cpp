@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021 fleroviux
+ */
+
+#include <util/log.hpp>
+#include <util/shared_memory.hpp>
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #define HAVE_MEMFD
+#endif
+
+namespace common {
+
+SharedMemory::SharedMemory(size_t capacity)
+    : capacity((capacity + kPageSize - 1) & ~(kPageSize - 1)) {
+#ifdef HAVE_MEMFD
+  fd = memfd_create("duality", MFD_CLOEXEC);
+  if (fd != -1) {
+    void* address = MAP_FAILED;
+    if (ftruncate(fd, this->capacity) == 0) {
+      address = mmap(nullptr, this->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (address != MAP_FAILED) {
+      data = static_cast<u8*>(address);
+      return;
+    }
+    close(fd);
+    fd = -1;
+  }
+#endif
+
+  // Fallback: the pool cannot be mapped elsewhere, but is usable otherwise.
+  buffer = std::make_unique<u8[]>(this->capacity + kPageSize);
+  data = reinterpret_cast<u8*>((reinterpret_cast<uintptr_t>(buffer.get()) + kPageSize - 1) & ~(kPageSize - 1));
+}
+
+SharedMemory::~SharedMemory() {
+#ifdef HAVE_MEMFD
+  if (fd != -1) {
+    munmap(data, capacity);
+    close(fd);
+  }
+#endif
+}
+
+auto SharedMemory::Allocate(size_t size) -> u8* {
+  size = (size + kPageSize - 1) & ~(kPageSize - 1);
+  ASSERT(used + size <= capacity, "SharedMemory: out of memory (requested {0} bytes)", size);
+  auto address = data + used;
+  used += size;
+  return address;
+}
+
+} // namespace common